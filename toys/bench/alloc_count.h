@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Replaces the global operator new and delete to count every allocation, so
+ * a benchmark can report allocations per operation. Replacements can't be
+ * inline, so include this from one translation unit of the program only.
+ */
+inline std::size_t g_allocations = 0;
+
+auto operator new(std::size_t size) -> void * {
+    ++g_allocations;
+    if (auto *ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+auto operator delete(void *ptr) noexcept -> void {
+    std::free(ptr);
+}
+
+auto operator delete(void *ptr, std::size_t) noexcept -> void {
+    std::free(ptr);
+}
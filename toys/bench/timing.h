@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <ratio>
+#include <string_view>
+
+/**
+ * Timers for the demos, which print "name: time unit" in the unit of _Period.
+ * measure_once times one call and leaves the rest of the line to the caller;
+ * measure warms up caches and the allocator with one call, then prints the
+ * mean of _Rounds calls with the mean of what they returned.
+ */
+template <typename _Period>
+inline constexpr auto kTimeUnit = std::string_view{"s"};
+
+template <>
+inline constexpr auto kTimeUnit<std::nano> = std::string_view{"ns"};
+
+template <>
+inline constexpr auto kTimeUnit<std::micro> = std::string_view{"us"};
+
+template <>
+inline constexpr auto kTimeUnit<std::milli> = std::string_view{"ms"};
+
+/* The result of fn(), after printing how long it took. */
+template <typename _Period = std::micro, typename _Fn>
+auto measure_once(std::string_view name, _Fn &&fn) -> decltype(fn()) {
+    const auto start = std::chrono::steady_clock::now();
+    auto result      = fn();
+    const auto stop  = std::chrono::steady_clock::now();
+    const auto time  = std::chrono::duration<double, _Period>(stop - start).count();
+    std::cout << std::format("{}: {:.2f} {}", name, time, kTimeUnit<_Period>);
+    return result;
+}
+
+/* The mean time of a call, in units of _Period. */
+template <std::size_t _Rounds, typename _Period = std::micro, typename _Fn>
+auto measure(std::string_view name, _Fn &&fn) -> double {
+    auto check       = fn();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < _Rounds; ++i)
+        check += fn();
+    const auto stop = std::chrono::steady_clock::now();
+    const auto time = std::chrono::duration<double, _Period>(stop - start).count();
+    const auto mean = time / _Rounds;
+    std::cout << std::format(
+        "{}: {:.2f} {} ({})\n", name, mean, kTimeUnit<_Period>, check / (_Rounds + 1)
+    );
+    return mean;
+}
@@ -0,0 +1,225 @@
+#include "../bench/alloc_count.h"
+#include "fmt.h"
+#include <bitset>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <format>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if __cpp_lib_format_ranges
+/* Routes a range to the standard std::range_formatter instead of ours. */
+template <typename _Range>
+struct std_range {
+    const _Range &range;
+};
+
+template <typename _Range>
+struct std::formatter<std_range<_Range>> {
+    constexpr auto parse(std::format_parse_context &ctx) {
+        return _M_impl.parse(ctx);
+    }
+
+    template <typename _FormatContext>
+    auto format(const std_range<_Range> &value, _FormatContext &ctx) const {
+        return _M_impl.format(value.range, ctx);
+    }
+
+private:
+    std::range_formatter<std::ranges::range_value_t<_Range>> _M_impl;
+};
+#endif
+
+struct point {
+    int x;
+    double y;
+};
+
+namespace {
+
+constexpr auto kElements = std::size_t{1} << 12;
+constexpr auto kDuration = std::chrono::milliseconds{200};
+
+/* Run fn repeatedly for about kDuration and report the averages per call. */
+template <typename _Fn>
+auto measure(std::string_view name, std::size_t elements, _Fn fn) -> std::string {
+    auto last        = fn(); // warm up
+    auto calls       = std::size_t{};
+    auto allocs      = g_allocations;
+    const auto start = std::chrono::steady_clock::now();
+    auto stop        = start;
+    for (; stop - start < kDuration; stop = std::chrono::steady_clock::now()) {
+        for (int i = 0; i < 16; ++i)
+            last = fn();
+        calls += 16;
+    }
+    allocs = g_allocations - allocs;
+
+    const auto ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::printf(
+        "%-28.*s %8.2f ns/elem %9.1f MB/s %6.2f allocs/format\n",
+        static_cast<int>(name.size()), name.data(), ns / calls / elements,
+        static_cast<double>(last.size()) * calls / ns * 1e3,
+        static_cast<double>(allocs) / calls
+    );
+    return last;
+}
+
+template <typename _Fn>
+auto hand_loop(std::size_t count, _Fn write) -> std::string {
+    auto result = std::string{};
+    result.reserve(count * 8);
+    result.push_back('[');
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i != 0)
+            result.append(", ");
+        write(result, i);
+    }
+    result.push_back(']');
+    return result;
+}
+
+template <typename _Tp>
+auto append_number(std::string &out, _Tp value) -> void {
+    char buffer[64];
+    out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+}
+
+auto check(std::string_view name, const std::string &lhs, const std::string &rhs) {
+    if (lhs != rhs)
+        std::printf("mismatch: %.*s\n", static_cast<int>(name.size()), name.data());
+}
+
+template <typename _Range>
+auto bench_std([[maybe_unused]] std::string_view name, [[maybe_unused]] const _Range &v) {
+#if __cpp_lib_format_ranges
+    measure(name, v.size(), [&] { return std::format("{}", std_range<_Range>{v}); });
+#endif
+}
+
+} // namespace
+
+auto main() -> int {
+    const auto n = kElements;
+
+    auto ints    = std::vector<int>(n);
+    auto doubles = std::vector<double>(n);
+    auto strings = std::vector<std::string>(n);
+    auto tuples  = std::vector<std::tuple<int, double>>(n);
+    auto pairs   = std::vector<std::pair<int, int>>(n);
+    auto options = std::vector<std::optional<int>>(n);
+    auto bitsets = std::vector<std::bitset<16>>(n);
+    auto points  = std::vector<point>(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto k = static_cast<int>(i * 2654435761u % 100000);
+        ints[i]      = k - 50000;
+        doubles[i]   = k / 64.0;
+        strings[i]   = std::to_string(k);
+        tuples[i]    = {k, k / 64.0};
+        pairs[i]     = {k, -k};
+        options[i]   = k % 3 ? std::optional{k} : std::nullopt;
+        bitsets[i]   = static_cast<unsigned long>(k);
+        points[i]    = {k, k / 64.0};
+    }
+
+    std::puts("== range<int> ==");
+    auto ours = measure("fmt.h {}", n, [&] { return std::format("{}", ints); });
+    measure("fmt.h format_reserved", n, [&] { return format_reserved("{}", ints); });
+    auto hand = measure("to_chars loop", n, [&] {
+        return hand_loop(n, [&](std::string &out, std::size_t i) {
+            append_number(out, ints[i]);
+        });
+    });
+    check("range<int>", ours, hand);
+    bench_std("std::range_formatter", ints);
+
+    std::puts("== range<double> ==");
+    ours = measure("fmt.h {}", n, [&] { return std::format("{}", doubles); });
+    hand = measure("to_chars loop", n, [&] {
+        return hand_loop(n, [&](std::string &out, std::size_t i) {
+            append_number(out, doubles[i]);
+        });
+    });
+    check("range<double>", ours, hand);
+    bench_std("std::range_formatter", doubles);
+
+    std::puts("== range<string> ==");
+    ours = measure("fmt.h {}", n, [&] { return std::format("{}", strings); });
+    hand = measure("append loop", n, [&] {
+        return hand_loop(n, [&](std::string &out, std::size_t i) {
+            out.append(strings[i]);
+        });
+    });
+    check("range<string>", ours, hand);
+
+    std::puts("== range<tuple<int, double>> ==");
+    ours = measure("fmt.h {}", n, [&] { return std::format("{}", tuples); });
+    hand = measure("to_chars loop", n, [&] {
+        return hand_loop(n, [&](std::string &out, std::size_t i) {
+            out.push_back('(');
+            append_number(out, std::get<0>(tuples[i]));
+            out.append(", ");
+            append_number(out, std::get<1>(tuples[i]));
+            out.push_back(')');
+        });
+    });
+    check("range<tuple>", ours, hand);
+
+    std::puts("== range<pair<int, int>> ==");
+    ours = measure("fmt.h {}", n, [&] { return std::format("{}", pairs); });
+    hand = measure("to_chars loop", n, [&] {
+        return hand_loop(n, [&](std::string &out, std::size_t i) {
+            out.push_back('(');
+            append_number(out, pairs[i].first);
+            out.append(", ");
+            append_number(out, pairs[i].second);
+            out.push_back(')');
+        });
+    });
+    check("range<pair>", ours, hand);
+
+    std::puts("== range<optional<int>> ==");
+    ours = measure("fmt.h {}", n, [&] { return std::format("{}", options); });
+    hand = measure("to_chars loop", n, [&] {
+        return hand_loop(n, [&](std::string &out, std::size_t i) {
+            if (options[i].has_value()) {
+                out.append("?<");
+                append_number(out, *options[i]);
+                out.push_back('>');
+            } else {
+                out.append("?None");
+            }
+        });
+    });
+    check("range<optional>", ours, hand);
+
+    std::puts("== range<bitset<16>> ==");
+    ours = measure("fmt.h {}", n, [&] { return std::format("{}", bitsets); });
+    hand = measure("to_string loop", n, [&] {
+        return hand_loop(n, [&](std::string &out, std::size_t i) {
+            out.append(bitsets[i].to_string());
+        });
+    });
+    check("range<bitset>", ours, hand);
+
+    // the same members as the tuple case, but through reflection
+    std::puts("== range<aggregate{int, double}> ==");
+    ours = measure("fmt.h {}", n, [&] { return std::format("{}", points); });
+    hand = measure("to_chars loop", n, [&] {
+        return hand_loop(n, [&](std::string &out, std::size_t i) {
+            out.push_back('(');
+            append_number(out, points[i].x);
+            out.append(", ");
+            append_number(out, points[i].y);
+            out.push_back(')');
+        });
+    });
+    check("range<aggregate>", ours, hand);
+}
@@ -1,9 +1,13 @@
 #include "fmt.h"
+#include "par.h"
 #include <array>
 #include <format>
 #include <forward_list>
 #include <iostream>
+#include <list>
 #include <map>
+#include <numeric>
+#include <set>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -37,5 +41,47 @@ auto main() -> int {
     // support aggregate type
     std::cout << std::format("struct: {}\n", MyTest{.age = 1});
     std::cout << std::format("bitset: {}\n", std::bitset<8>{0b10001110});
+    // arithmetic ranges skip the per-element format_to
+    const int raw[] = {-1, 0, 1};
+    std::cout << std::format(
+        "numbers: {} {} {}\n", std::vector{0.5, -2.25, 1e300}, raw,
+        std::set<unsigned long>{1, 2, 3}
+    );
+    auto buffer = std::string{};
+    std::format_to(std::back_inserter(buffer), "{}", std::vector<short>{7, 8, 9});
+    std::cout << std::format("appended: {}\n", buffer);
+
+    // single allocation through size hints, or no allocation with a buffer
+    // elements of unbounded length, like the vectors of ragged, give no hint
+    const auto dump   = std::map<int, std::pair<double, bool>>{{1, {0.5, true}}, {2, {}}};
+    const auto ragged = std::map<int, std::vector<double>>{{1, {0.5, 1.5}}, {2, {}}};
+    std::cout << std::format(
+        "hint: {} >= {}, {}\n", formatted_size_hint("{}", dump),
+        format_reserved("{}", dump).size(), formatted_size_hint("{}", ragged)
+    );
+    // bounded output: at most 3 elements per range and 2 levels of nesting
+    const auto nested = std::vector<std::vector<int>>{{1, 2, 3, 4, 5}, {6}, {7}, {8}};
+    std::cout << std::format("bounded: {:.3} {:.0}\n", std::vector<int>(1000, 1), nested);
+    std::cout << std::format(
+        "bounded: {:.3,1} {:.2,2}\n", nested, std::list<std::list<int>>{{1, 2, 3}, {4}}
+    );
+
+    char small[2][16];
+    const auto fits = format_into(small[0], "{}", std::pair{1, 2});
+    const auto over = format_into(small[1], "{}", std::vector{1, 2, 3, 4, 5, 6, 7});
+    const auto none = format_into({}, "{}", std::string{});
+    std::cout << std::format(
+        "into: {} {}, {} {}, empty {}\n", fits.view(), fits.overflowed(), over.view(),
+        over.overflowed(), none.overflowed()
+    );
+
+    // large random-access ranges can be formatted in chunks on several threads
+    auto large = std::vector<double>(1 << 16);
+    std::iota(large.begin(), large.end(), 0.25);
+    const auto grid = std::vector<std::vector<int>>(1 << 13, {1, 2});
+    std::cout << std::format(
+        "parallel: {} {}\n", format_parallel(large, 4) == std::format("{}", large),
+        format_parallel(grid) == std::format("{}", grid)
+    );
     using namespace std::string_literals;
 }
@@ -1,13 +1,21 @@
 #pragma once
 
 #include "../reflect/rf.h"
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
 #include <format>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <map>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <string>
 #include <string_view>
 #include <tuple>
 #include <type_traits>
@@ -43,6 +51,76 @@ consteval auto get_format_str() -> std::string_view {
     return std::string_view(_S_fmt.data(), _S_fmt.size());
 }
 
+// numbers whose std::formatter output with "{}" equals plain std::to_chars
+template <typename _Tp>
+concept to_chars_number =
+    (std::integral<_Tp> && !std::same_as<_Tp, bool> && !std::same_as<_Tp, char> &&
+     !std::same_as<_Tp, wchar_t> && !std::same_as<_Tp, char8_t> &&
+     !std::same_as<_Tp, char16_t> && !std::same_as<_Tp, char32_t>) ||
+    std::floating_point<_Tp>;
+
+template <to_chars_number _Tp>
+inline constexpr std::size_t max_chars_v =
+    std::floating_point<_Tp> ? 64 : std::numeric_limits<_Tp>::digits10 + 3;
+
+// the sum of the hints and extra, or no hint if any of them is missing
+template <std::same_as<std::optional<std::size_t>>... _Hints>
+constexpr auto sum_hints(std::size_t extra, const _Hints &...hints)
+    -> std::optional<std::size_t> {
+    if ((!hints.has_value() || ...))
+        return std::nullopt;
+    return (extra + ... + *hints);
+}
+
+/* An upper bound of the length of std::format("{}", value) for every value of _Tp. */
+template <typename _Tp>
+inline constexpr auto max_size_v = std::optional<std::size_t>{};
+
+template <to_chars_number _Tp>
+inline constexpr auto max_size_v<_Tp> = std::optional<std::size_t>{max_chars_v<_Tp>};
+
+template <>
+inline constexpr auto max_size_v<bool> = std::optional<std::size_t>{5}; // "false"
+
+template <>
+inline constexpr auto max_size_v<char> = std::optional<std::size_t>{1};
+
+template <std::size_t _Nm>
+inline constexpr auto max_size_v<std::bitset<_Nm>> = std::optional<std::size_t>{_Nm};
+
+template <typename... _Args>
+inline constexpr auto max_size_v<std::tuple<_Args...>> =
+    sum_hints(2 + 2 * sizeof...(_Args), max_size_v<std::remove_cvref_t<_Args>>...);
+
+template <typename _T1, typename _T2>
+inline constexpr auto max_size_v<std::pair<_T1, _T2>> =
+    sum_hints(4, max_size_v<std::remove_cv_t<_T1>>, max_size_v<std::remove_cv_t<_T2>>);
+
+template <typename _Tp>
+inline constexpr auto max_size_v<std::optional<_Tp>> = sum_hints(5, max_size_v<_Tp>);
+
+template <reflect::aggregate_type _Tp>
+    requires(!std::ranges::range<_Tp>)
+inline constexpr auto max_size_v<_Tp> = max_size_v<
+    std::remove_cvref_t<decltype(reflect::tuplify(std::declval<const _Tp &>()))>>;
+
+/**
+ * An upper bound of the length of std::format("{}", value), in O(1) or at
+ * most O(members), or no hint when no such bound is cheap. Formatters may
+ * provide it through a size_hint(value) member, which is exact or an upper
+ * bound. Nothing is formatted to find it.
+ */
+template <typename _Tp>
+inline auto size_hint(const _Tp &value) -> std::optional<std::size_t> {
+    using _Fmt = std::formatter<_Tp>;
+    if constexpr (requires(const _Fmt &fmt) { fmt.size_hint(value); })
+        return _Fmt{}.size_hint(value);
+    else if constexpr (std::convertible_to<const _Tp &, std::string_view>)
+        return std::string_view(value).size();
+    else
+        return max_size_v<_Tp>;
+}
+
 } // namespace __detail
 
 template <typename... _Args>
@@ -58,6 +136,17 @@ struct std::formatter<std::tuple<_Args...>> {
             return std::format_to(ctx.out(), fmt, std::get<_I>(value)...);
         }(std::make_index_sequence<sizeof...(_Args)>{});
     }
+
+    auto size_hint(const std::tuple<_Args...> &value) const
+        -> std::optional<std::size_t> {
+        return std::apply(
+            [](const auto &...args) {
+                const auto extra = 2 + 2 * sizeof...(_Args);
+                return ::__detail::sum_hints(extra, ::__detail::size_hint(args)...);
+            },
+            value
+        );
+    }
 };
 
 template <typename _T1, typename _T2>
@@ -70,6 +159,12 @@ struct std::formatter<std::pair<_T1, _T2>> {
     auto format(const std::pair<_T1, _T2> &value, _FormatContext &ctx) const {
         return std::format_to(ctx.out(), "({}, {})", value.first, value.second);
     }
+
+    auto size_hint(const std::pair<_T1, _T2> &value) const -> std::optional<std::size_t> {
+        return ::__detail::sum_hints(
+            4, ::__detail::size_hint(value.first), ::__detail::size_hint(value.second)
+        );
+    }
 };
 
 template <typename _T>
@@ -86,6 +181,12 @@ struct std::formatter<std::optional<_T>> {
             return std::format_to(ctx.out(), "?None");
         }
     }
+
+    auto size_hint(const std::optional<_T> &value) const -> std::optional<std::size_t> {
+        if (!value.has_value())
+            return 5;
+        return ::__detail::sum_hints(3, ::__detail::size_hint(value.value()));
+    }
 };
 
 template <typename _Tp>
@@ -95,28 +196,221 @@ inline constexpr bool is_char_array_v<char[]> = true;
 template <std::size_t _Num>
 inline constexpr bool is_char_array_v<char[_Num]> = true;
 
-template <std::ranges::range _Range>
-    requires(!is_char_array_v<_Range>)
+template <typename _Range>
+concept formattable_range = std::ranges::range<_Range> && !is_char_array_v<_Range>;
+
+namespace __detail {
+
+/**
+ * Bounds parsed from a range format spec "[.limit][,depth]", e.g. "{:.16,2}".
+ * At most limit elements of each range are printed, as "[a, b, ..., (N more)]",
+ * and ranges nested deeper than depth levels are printed as "[...]".
+ */
+struct range_bounds {
+    static constexpr auto kNone = std::numeric_limits<std::size_t>::max();
+
+    std::size_t limit = kNone;
+    std::size_t depth = kNone;
+
+    constexpr auto parse(std::format_parse_context &ctx) {
+        auto iter       = ctx.begin();
+        const auto end  = ctx.end();
+        const auto read = [&] {
+            if (iter == end || *iter < '0' || *iter > '9')
+                throw std::format_error("Invalid range format spec");
+            auto value = std::size_t{};
+            while (iter != end && *iter >= '0' && *iter <= '9')
+                value = value * 10 + static_cast<std::size_t>(*iter++ - '0');
+            return value;
+        };
+        if (iter != end && *iter == '.')
+            limit = (++iter, read());
+        if (iter != end && *iter == ',')
+            depth = (++iter, read());
+        if (iter != end && *iter != '}')
+            throw std::format_error("Invalid range format spec");
+        return iter;
+    }
+
+    // bounds for the ranges nested in this one
+    constexpr auto nested() const -> range_bounds {
+        return {.limit = limit, .depth = depth == kNone ? kNone : depth - 1};
+    }
+};
+
+// the number of elements in [iter, end), in O(1) if the range is sized
+template <typename _Range, typename _Iter>
+inline auto count_rest(const _Range &range, _Iter iter, std::size_t done) -> std::size_t {
+    if constexpr (std::ranges::sized_range<_Range>) {
+        return static_cast<std::size_t>(std::ranges::size(range)) - done;
+    } else {
+        const auto rest = std::ranges::distance(iter, std::ranges::end(range));
+        return static_cast<std::size_t>(rest);
+    }
+}
+
+// "[a, b, c]" with to_chars into a stack buffer, flushed only when nearly full
+template <typename _Range, typename _Out>
+inline auto format_number_range(const _Range &range, _Out out, range_bounds bounds = {})
+    -> _Out {
+    using _Tp            = std::ranges::range_value_t<_Range>;
+    constexpr auto kSize = std::size_t{1024};
+    constexpr auto kNeed = max_chars_v<_Tp> + 2; // ", " or the closing "]"
+
+    if (bounds.depth == 0)
+        return std::ranges::copy(std::string_view{"[...]"}, std::move(out)).out;
+
+    char buffer[kSize];
+    char *ptr = buffer;
+
+    const auto put = [&](const _Tp &value) {
+        if (static_cast<std::size_t>(buffer + kSize - ptr) < kNeed) {
+            out = std::ranges::copy(buffer, ptr, std::move(out)).out;
+            ptr = buffer;
+        }
+        ptr = std::to_chars(ptr, buffer + kSize, value).ptr;
+    };
+    // print at most limit elements, and return where it stopped
+    const auto put_all = [&](auto begin, auto end) {
+        if (begin != end && bounds.limit != 0) [[likely]] {
+            put(*begin);
+            for (auto count = std::size_t{1}; ++begin != end && count != bounds.limit;
+                 ++count) {
+                ptr[0] = ',';
+                ptr[1] = ' ';
+                ptr += 2;
+                put(*begin);
+            }
+        }
+        return begin;
+    };
+
+    *ptr++    = '[';
+    auto done = std::size_t{};
+    auto rest = std::size_t{};
+    if constexpr (std::ranges::contiguous_range<_Range> &&
+                  std::ranges::sized_range<_Range>) {
+        const auto *data = std::ranges::data(range);
+        const auto size  = static_cast<std::size_t>(std::ranges::size(range));
+        done             = static_cast<std::size_t>(put_all(data, data + size) - data);
+        rest             = size - done;
+    } else {
+        const auto begin = std::ranges::begin(range);
+        const auto iter  = put_all(begin, std::ranges::end(range));
+        if (iter != std::ranges::end(range)) {
+            done = static_cast<std::size_t>(std::ranges::distance(begin, iter));
+            rest = count_rest(range, iter, done);
+        }
+    }
+    if (rest != 0) {
+        constexpr auto kTail = std::size_t{64}; // ", ..., (" + count + " more)]"
+        if (static_cast<std::size_t>(buffer + kSize - ptr) < kTail) {
+            out = std::ranges::copy(buffer, ptr, std::move(out)).out;
+            ptr = buffer;
+        }
+        const auto head = std::string_view{done != 0 ? ", ..., (" : "..., ("};
+        ptr             = std::ranges::copy(head, ptr).out;
+        ptr             = std::to_chars(ptr, buffer + kSize, rest).ptr;
+        ptr             = std::ranges::copy(std::string_view{" more)"}, ptr).out;
+    }
+    *ptr++ = ']';
+    return std::ranges::copy(buffer, ptr, std::move(out)).out;
+}
+
+template <typename _Tp>
+concept bounded_formattable = requires(std::formatter<_Tp> &fmt, range_bounds bounds) {
+    fmt.set_bounds(bounds);
+};
+
+} // namespace __detail
+
+template <formattable_range _Range>
 struct std::formatter<_Range> {
     constexpr auto parse(::std::format_parse_context &ctx) {
-        return ctx.begin();
+        return _M_bounds.parse(ctx);
     }
 
     template <typename _FormatContext>
     auto format(const _Range &range, _FormatContext &ctx) const {
-        auto iter  = ctx.out();
+        auto iter = ctx.out();
+        if (_M_bounds.depth == 0)
+            return std::format_to(iter, "[...]");
+
         auto begin = std::ranges::begin(range);
         auto end   = std::ranges::end(range);
+        auto count = std::size_t{};
         // format part.
         iter = std::format_to(iter, "[");
-        if (begin != end) [[likely]] {
-            iter = std::format_to(iter, "{}", *begin);
-            while (++begin != end)
-                iter = std::format_to(iter, ", {}", *begin);
+        for (; begin != end && count != _M_bounds.limit; ++begin, ++count) {
+            if (count != 0)
+                iter = std::format_to(iter, ", ");
+            iter = this->_M_format_element(*begin, ctx, iter);
+        }
+        if (begin != end) {
+            const auto rest = ::__detail::count_rest(range, begin, count);
+            iter = std::format_to(iter, "{}..., ({} more)", count ? ", " : "", rest);
         }
         iter = std::format_to(iter, "]");
         return iter;
     }
+
+    // only for sized ranges of elements with a bound for every value, in O(1)
+    auto size_hint(const _Range &range) const -> std::optional<std::size_t> {
+        using _Tp            = std::ranges::range_value_t<_Range>;
+        constexpr auto bound = ::__detail::max_size_v<_Tp>;
+        if constexpr (std::ranges::sized_range<_Range> && bound.has_value())
+            return 2 + static_cast<std::size_t>(std::ranges::size(range)) * (*bound + 2);
+        else
+            return std::nullopt;
+    }
+
+    constexpr auto set_bounds(::__detail::range_bounds bounds) -> void {
+        _M_bounds = bounds;
+    }
+
+private:
+    template <typename _Tp, typename _FormatContext, typename _Iter>
+    auto _M_format_element(const _Tp &value, _FormatContext &ctx, _Iter iter) const {
+        if constexpr (::__detail::bounded_formattable<_Tp>) {
+            // pass the bounds down to nested ranges
+            auto fmt = std::formatter<_Tp>{};
+            fmt.set_bounds(_M_bounds.nested());
+            ctx.advance_to(std::move(iter));
+            return fmt.format(value, ctx);
+        } else {
+            return std::format_to(std::move(iter), "{}", value);
+        }
+    }
+
+    ::__detail::range_bounds _M_bounds{};
+};
+
+template <formattable_range _Range>
+    requires ::__detail::to_chars_number<std::ranges::range_value_t<_Range>>
+struct std::formatter<_Range> {
+    constexpr auto parse(::std::format_parse_context &ctx) {
+        return _M_bounds.parse(ctx);
+    }
+
+    template <typename _FormatContext>
+    auto format(const _Range &range, _FormatContext &ctx) const {
+        return ::__detail::format_number_range(range, ctx.out(), _M_bounds);
+    }
+
+    auto size_hint(const _Range &range) const -> std::optional<std::size_t> {
+        using _Tp = std::ranges::range_value_t<_Range>;
+        if constexpr (std::ranges::sized_range<_Range>)
+            return 2 + std::ranges::size(range) * (::__detail::max_chars_v<_Tp> + 2);
+        else
+            return std::nullopt; // counting would walk the whole range
+    }
+
+    constexpr auto set_bounds(::__detail::range_bounds bounds) -> void {
+        _M_bounds = bounds;
+    }
+
+private:
+    ::__detail::range_bounds _M_bounds{};
 };
 
 template <reflect::aggregate_type _Tp>
@@ -130,6 +424,10 @@ struct std::formatter<_Tp> {
     auto format(const _Tp &value, _FormatContext &ctx) const {
         return std::format_to(ctx.out(), "{}", reflect::tuplify(value));
     }
+
+    auto size_hint(const _Tp &value) const -> std::optional<std::size_t> {
+        return ::__detail::size_hint(reflect::tuplify(value));
+    }
 };
 
 template <std::size_t _Nm>
@@ -142,4 +440,99 @@ struct std::formatter<std::bitset<_Nm>> {
     auto format(const std::bitset<_Nm> &value, _FormatContext &ctx) const {
         return std::format_to(ctx.out(), "{}", value.to_string());
     }
+
+    auto size_hint(const std::bitset<_Nm> &) const -> std::optional<std::size_t> {
+        return _Nm;
+    }
+};
+
+template <typename... _Args>
+inline auto formatted_size_hint(std::format_string<_Args...> fmt, const _Args &...args)
+    -> std::optional<std::size_t> {
+    // the literal part is at most the whole format string
+    return ::__detail::sum_hints(fmt.get().size(), ::__detail::size_hint(args)...);
+}
+
+/**
+ * Format into a std::string with a single allocation, sized by size_hint, or
+ * growing as usual when an argument gives no hint.
+ */
+template <typename... _Args>
+inline auto format_reserved(std::format_string<_Args...> fmt, _Args &&...args)
+    -> std::string {
+    auto result = std::string{};
+    if (const auto hint = formatted_size_hint<_Args...>(fmt, args...))
+        result.reserve(*hint);
+    std::format_to(std::back_inserter(result), fmt, std::forward<_Args>(args)...);
+    return result;
+}
+
+struct format_into_result {
+public:
+    format_into_result(std::string_view view) : _M_view(view) {}
+    format_into_result(std::string heap) :
+        _M_heap(std::move(heap)), _M_overflowed(true) {}
+
+    auto view() const -> std::string_view {
+        return this->overflowed() ? std::string_view{_M_heap} : _M_view;
+    }
+
+    /* Whether the buffer was too small, so the text lives on the heap. */
+    auto overflowed() const -> bool {
+        return _M_overflowed;
+    }
+
+private:
+    std::string_view _M_view;
+    std::string _M_heap;
+    bool _M_overflowed = false;
 };
+
+namespace __detail {
+
+// write while there is room, but keep counting the full length
+struct bounded_writer {
+    using difference_type = std::ptrdiff_t;
+
+    char *ptr;
+    char *end;
+    std::size_t count;
+
+    auto operator*() -> bounded_writer & {
+        return *this;
+    }
+    auto operator++() -> bounded_writer & {
+        return *this;
+    }
+    auto operator++(int) -> bounded_writer & {
+        return *this;
+    }
+    auto operator=(char c) -> bounded_writer & {
+        if (ptr != end)
+            *ptr++ = c;
+        ++count;
+        return *this;
+    }
+};
+
+} // namespace __detail
+
+/**
+ * Format into a caller-provided buffer. On overflow, the exact size is known
+ * from the first pass, so the fallback formats again into one allocation.
+ */
+template <typename... _Args>
+inline auto
+format_into(std::span<char> buffer, std::format_string<_Args...> fmt, _Args &&...args)
+    -> format_into_result {
+    const auto store  = std::make_format_args(args...);
+    const auto writer = std::vformat_to(
+        ::__detail::bounded_writer{buffer.data(), buffer.data() + buffer.size(), 0},
+        fmt.get(), store
+    );
+    if (writer.count <= buffer.size())
+        return std::string_view{buffer.data(), writer.count};
+    auto heap = std::string(writer.count, '\0');
+    std::vformat_to(heap.data(), fmt.get(), store);
+    return heap;
+}
@@ -0,0 +1,226 @@
+#pragma once
+#include "fmt.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <iterator>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace __detail {
+
+inline constexpr auto kMinChunk = std::size_t{1} << 12; // elements per chunk
+
+template <typename _Tp>
+inline auto append_element(std::string &out, const _Tp &value) -> void {
+    if constexpr (to_chars_number<_Tp>) {
+        char buffer[max_chars_v<_Tp>];
+        out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+    } else {
+        std::format_to(std::back_inserter(out), "{}", value);
+    }
+}
+
+inline auto default_threads() -> std::size_t {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Workers that live for the whole process, so a call does not pay for
+ * starting and joining threads. One job runs at a time: up to helpers
+ * workers join the calling thread on it, and a caller that finds the pool
+ * busy (another thread, or a nested call) runs the job alone. The job must
+ * not throw, and must be done once the caller's own run of it returns.
+ */
+struct worker_pool {
+    explicit worker_pool(std::size_t workers) {
+        _M_workers.reserve(workers);
+        for (std::size_t i = 0; i < workers; ++i)
+            _M_workers.emplace_back([this] { this->_M_serve(); });
+    }
+
+    worker_pool(const worker_pool &)                     = delete;
+    auto operator=(const worker_pool &) -> worker_pool & = delete;
+
+    ~worker_pool() {
+        {
+            auto lock = std::lock_guard{_M_mutex};
+            _M_stop   = true;
+        }
+        _M_wake.notify_all();
+    }
+
+    static auto shared() -> worker_pool & {
+        static auto pool = worker_pool{default_threads() - 1};
+        return pool;
+    }
+
+    template <typename _Fn>
+    auto run(std::size_t helpers, const _Fn &fn) -> void {
+        auto busy = std::unique_lock{_M_busy, std::try_to_lock};
+        helpers   = std::min(helpers, _M_workers.size());
+        if (!busy.owns_lock() || helpers == 0)
+            return fn();
+
+        {
+            auto lock = std::lock_guard{_M_mutex};
+            _M_job    = [](const void *ctx) { (*static_cast<const _Fn *>(ctx))(); };
+            _M_ctx    = &fn;
+            _M_wanted = helpers;
+        }
+        _M_wake.notify_all();
+        fn();
+
+        // all the work is taken by now, so workers yet to start may skip it
+        auto lock = std::unique_lock{_M_mutex};
+        _M_wanted = 0;
+        _M_done.wait(lock, [this] { return _M_active == 0; });
+    }
+
+private:
+    auto _M_serve() -> void {
+        auto lock = std::unique_lock{_M_mutex};
+        while (true) {
+            _M_wake.wait(lock, [this] { return _M_stop || _M_wanted > 0; });
+            if (_M_stop)
+                return;
+            --_M_wanted;
+            ++_M_active;
+            const auto job = _M_job;
+            const auto ctx = _M_ctx;
+            lock.unlock();
+            job(ctx);
+            lock.lock();
+            if (--_M_active == 0)
+                _M_done.notify_all();
+        }
+    }
+
+    std::mutex _M_busy;  // held by the caller of the running job
+    std::mutex _M_mutex; // guards everything below
+    std::condition_variable _M_wake;
+    std::condition_variable _M_done;
+    void (*_M_job)(const void *){};
+    const void *_M_ctx{};
+    std::size_t _M_wanted{}; // workers still to join the job
+    std::size_t _M_active{}; // workers running the job
+    bool _M_stop{};
+    std::vector<std::jthread> _M_workers; // last, so they are joined first
+};
+
+} // namespace __detail
+
+template <typename _Range>
+concept parallel_formattable_range =
+    formattable_range<_Range> && std::ranges::random_access_range<const _Range> &&
+    std::ranges::sized_range<const _Range>;
+
+/**
+ * Format the range as std::format("{}", range) would, but in chunks.
+ * Chunks are formatted by up to threads workers, each into its own buffer:
+ * the calling thread and the shared worker_pool, so at most default_threads().
+ * Concatenating the returned chunks in order gives the sequential result.
+ */
+template <parallel_formattable_range _Range>
+inline auto format_chunks(const _Range &range, std::size_t threads = 0)
+    -> std::vector<std::string> {
+    if (threads == 0)
+        threads = __detail::default_threads();
+
+    const auto size   = static_cast<std::size_t>(std::ranges::size(range));
+    const auto wanted = std::max<std::size_t>(1, size / __detail::kMinChunk);
+    const auto chunks = std::min(wanted, threads * 4); // a few per thread to balance
+    const auto begin  = std::ranges::begin(range);
+
+    auto result = std::vector<std::string>(chunks);
+    auto errors = std::vector<std::exception_ptr>(chunks);
+    auto next   = std::atomic<std::size_t>{};
+
+    const auto work = [&] {
+        auto k = std::size_t{};
+        while ((k = next.fetch_add(1, std::memory_order_relaxed)) < chunks) {
+            try {
+                auto &out       = result[k];
+                const auto from = size * k / chunks;
+                const auto to   = size * (k + 1) / chunks;
+                if (k == 0)
+                    out.push_back('[');
+                for (auto i = from; i != to; ++i) {
+                    if (i != 0)
+                        out.append(", ");
+                    using _Diff = std::ranges::range_difference_t<const _Range>;
+                    __detail::append_element(out, begin[static_cast<_Diff>(i)]);
+                }
+                if (k + 1 == chunks)
+                    out.push_back(']');
+            } catch (...) {
+                errors[k] = std::current_exception();
+            }
+        }
+    };
+
+    // the calling thread takes part as well
+    __detail::worker_pool::shared().run(std::min(threads, chunks) - 1, work);
+
+    for (auto &error : errors)
+        if (error != nullptr)
+            std::rethrow_exception(error);
+    return result;
+}
+
+/* Same output as std::format("{}", range), formatted in parallel. */
+template <parallel_formattable_range _Range>
+inline auto format_parallel(const _Range &range, std::size_t threads = 0) -> std::string {
+    const auto chunks = format_chunks(range, threads);
+    auto total        = std::size_t{};
+    for (const auto &chunk : chunks)
+        total += chunk.size();
+    auto result = std::string{};
+    result.reserve(total);
+    for (const auto &chunk : chunks)
+        result.append(chunk);
+    return result;
+}
+
+/* Format the range in parallel and hand the chunks to writev as they are. */
+template <parallel_formattable_range _Range>
+inline auto write_parallel(int fd, const _Range &range, std::size_t threads = 0) -> void {
+    const auto chunks = format_chunks(range, threads);
+    auto iovecs       = std::vector<::iovec>{};
+    iovecs.reserve(chunks.size());
+    for (const auto &chunk : chunks)
+        iovecs.push_back({const_cast<char *>(chunk.data()), chunk.size()});
+
+    auto iter = iovecs.begin();
+    while (iter != iovecs.end()) {
+        const auto count = std::min<std::ptrdiff_t>(iovecs.end() - iter, IOV_MAX);
+        auto written     = ::writev(fd, std::to_address(iter), static_cast<int>(count));
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "writev");
+        }
+        // skip what was fully written, and advance into a partially written one
+        for (; iter != iovecs.end() && static_cast<std::size_t>(written) >= iter->iov_len;
+             ++iter)
+            written -= static_cast<::ssize_t>(iter->iov_len);
+        if (iter != iovecs.end()) {
+            iter->iov_base = static_cast<char *>(iter->iov_base) + written;
+            iter->iov_len -= static_cast<std::size_t>(written);
+        }
+    }
+}
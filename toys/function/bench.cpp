@@ -0,0 +1,115 @@
+#include "../bench/alloc_count.h"
+#include "fv.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+constexpr auto kTasks  = std::size_t{1} << 12;
+constexpr auto kRounds = 256;
+
+/**
+ * Fill a task queue with kTasks closures of 32 bytes, which is beyond the
+ * small buffer of std::function, then move them out and run them.
+ */
+template <typename _Task>
+auto bench_queue(std::string_view name) -> void {
+    auto queue = std::vector<_Task>{};
+    auto moved = std::vector<_Task>{};
+    auto sum   = long{};
+    auto base  = long{1};
+    queue.reserve(kTasks);
+    moved.reserve(kTasks);
+
+    const auto allocs = g_allocations;
+    const auto start  = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (std::size_t i = 0; i < kTasks; ++i) {
+            const auto a = static_cast<long>(i), b = a * 3, c = a ^ 5;
+            queue.emplace_back([a, b, c, ptr = &base](long x) {
+                return a + b * x + c + *ptr;
+            });
+        }
+        for (auto &task : queue)
+            moved.push_back(std::move(task));
+        for (auto &task : moved)
+            sum += task(round);
+        queue.clear();
+        moved.clear();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    const auto tasks = static_cast<double>(kTasks) * kRounds;
+    const auto ns    = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::printf(
+        "%-24.*s %7.2f ns/task %6.2f allocs/task (sum %ld)\n",
+        static_cast<int>(name.size()), name.data(), ns / tasks,
+        static_cast<double>(g_allocations - allocs) / tasks, sum
+    );
+}
+
+template <typename _Fn>
+auto report(std::string_view name, std::size_t calls, _Fn fn) -> void {
+    const auto start = std::chrono::steady_clock::now();
+    const auto sum   = fn();
+    const auto stop  = std::chrono::steady_clock::now();
+    const auto ns    = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::printf(
+        "%-24.*s %7.2f ns/call (sum %ld)\n", static_cast<int>(name.size()), name.data(),
+        ns / calls, sum
+    );
+}
+
+/* One indirect call per element, against one per batch, against no erasure. */
+auto bench_batch() -> void {
+    auto args = std::vector<std::tuple<long, long>>(kTasks);
+    auto out  = std::vector<long>(kTasks);
+    for (std::size_t i = 0; i < kTasks; ++i)
+        args[i] = {static_cast<long>(i), static_cast<long>(i) * 3};
+
+    auto scale     = long{7};
+    const auto fma = [&scale](long a, long b) { return a * scale + b; };
+    const auto fv  = function_view<long(long, long)>{fma};
+    const auto bv  = batch_view<long(long, long)>{fma};
+    const auto sum = [&out] {
+        auto result = long{};
+        for (const auto value : out)
+            result += value;
+        return result;
+    };
+
+    const auto calls = kTasks * kRounds;
+    report("function_view per call", calls, [&] {
+        for (int round = 0; round < kRounds; ++round)
+            for (std::size_t i = 0; i < kTasks; ++i)
+                out[i] = std::apply([&](long a, long b) { return fv(+a, +b); }, args[i]);
+        return sum();
+    });
+    report("function_view batch", calls, [&] {
+        for (int round = 0; round < kRounds; ++round)
+            bv(args, out);
+        return sum();
+    });
+    report("direct loop", calls, [&] {
+        for (int round = 0; round < kRounds; ++round)
+            for (std::size_t i = 0; i < kTasks; ++i)
+                out[i] = std::apply(fma, args[i]);
+        return sum();
+    });
+}
+
+} // namespace
+
+auto main() -> int {
+    bench_queue<std::function<long(long)>>("std::function");
+#if __cpp_lib_move_only_function
+    bench_queue<std::move_only_function<long(long)>>("std::move_only_function");
+#endif
+    bench_queue<inplace_function<long(long)>>("inplace_function");
+    bench_batch();
+}
@@ -1,10 +1,46 @@
 #include "fv.h"
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+static auto twice(int x) -> int {
+    return x * 2;
+}
+
+struct counter {
+    int total = 0;
+    auto add(int x) -> int {
+        return total += x;
+    }
+};
 
 auto main() -> int {
     auto fv             = function_view{[](int a, int b) { return a + b; }};
     const auto callable = std::function{fv};
     auto fv2            = function_view{callable};
     std::cout << int(fv2(fv(255, 3), 1)) << '\n';
+
+    // the function is bound into the trampoline, so no pointer is loaded
+    auto direct = function_view{nontype<&twice>};
+    auto c      = counter{};
+    auto method = function_view<int(int)>{nontype<&counter::add>, c};
+    method(direct(20));
+    std::cout << method(2) << '\n';
+
+    // owning and move-only, so it may capture a std::unique_ptr
+    auto tasks = std::vector<inplace_function<int(int)>>{};
+    tasks.emplace_back([p = std::make_unique<int>(2)](int x) { return x * *p; });
+    tasks.emplace_back([](int x) { return x + 1; });
+    auto moved = std::move(tasks.front());
+    std::cout << moved(20) + tasks.back()(1) << ' ' << bool(tasks.front()) << '\n';
+
+    // one indirect call for the whole batch, the loop runs in the trampoline
+    auto pairs       = std::vector<std::tuple<int, int>>{{1, 2}, {3, 4}, {5, 6}};
+    auto results     = std::vector<int>(pairs.size());
+    const auto add   = batch_view{[](int a, int b) { return a + b; }};
+    add(pairs, results);
+    std::cout << results[0] << ' ' << results[1] << ' ' << results[2] << '\n';
 }
@@ -1,13 +1,25 @@
 #pragma once
 #include <bit>
 #include <concepts>
+#include <cstddef>
 #include <functional>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
 template <class _Signature>
 struct function_view;
 
+template <class _Signature>
+struct batch_view;
+
+template <class _Signature>
+struct multicast;
+
 template <typename _Fn>
 inline constexpr auto is_function_view = false;
 template <typename _Signature>
@@ -24,15 +36,146 @@ template <typename _Ret2, typename _Ret>
 concept can_convert_from = // can convert from _Ret to _Ret2 and not identical
     requires { static_cast<_Ret2>(std::declval<_Ret>()); } && !std::same_as<_Ret2, _Ret>;
 
+namespace __detail {
+
+/**
+ * Call the trampoline _Call once per tuple of arguments. As _Call is known
+ * here, the loop makes direct calls that the compiler may inline.
+ * Results are stored into out, unless it is null.
+ */
+template <const auto &_Call, typename _Ret, typename... _Args>
+inline auto invoke_batch(void *ctx, std::tuple<_Args...> *args, std::size_t n, void *out)
+    -> void {
+    const auto call = [ctx](auto &...values) -> _Ret {
+        return _Call(ctx, std::forward<_Args>(values)...);
+    };
+    if constexpr (std::is_object_v<_Ret> && std::is_move_assignable_v<_Ret>) {
+        if (out != nullptr) {
+            auto *result = static_cast<_Ret *>(out);
+            for (std::size_t i = 0; i < n; ++i)
+                result[i] = std::apply(call, args[i]);
+            return;
+        }
+    }
+    for (std::size_t i = 0; i < n; ++i)
+        std::apply(call, args[i]);
+}
+
+/* A callable erased into a trampoline, a constant with static storage, and a context. */
+template <const auto &_Call>
+struct erased {
+    void *ctx;
+};
+
+template <typename _Ret, typename... _Args>
+using batch_t = void (*)(void *, std::tuple<_Args...> *, std::size_t, void *);
+
+template <typename _Ret>
+concept batch_result = std::is_object_v<_Ret> && std::is_move_assignable_v<_Ret>;
+
+inline auto check_batch(std::size_t args, std::size_t out) -> void {
+    if (out < args)
+        throw std::invalid_argument("Output span is shorter than the batch");
+}
+
+/* What the single trampoline of an inplace_function is asked to do. */
+enum class inplace_op { call, batch, move, destroy };
+
+/* Room for the result of a call, which is moved out once it is filled. */
+template <typename _Ret>
+struct call_result {
+    call_result() {}
+    ~call_result() {}
+
+    template <typename _Fn>
+    auto emplace(_Fn &&fn) -> void {
+        ::new (static_cast<void *>(std::addressof(value))) _Ret(fn());
+    }
+
+    auto take() -> _Ret {
+        auto result = _Ret(std::move(value));
+        std::destroy_at(std::addressof(value));
+        return result;
+    }
+
+    union {
+        _Ret value;
+    };
+};
+
+template <typename _Ret>
+    requires std::is_reference_v<_Ret>
+struct call_result<_Ret> {
+    template <typename _Fn>
+    auto emplace(_Fn &&fn) -> void {
+        value = std::addressof(fn());
+    }
+
+    auto take() -> _Ret {
+        return static_cast<_Ret>(*value);
+    }
+
+    std::remove_reference_t<_Ret> *value;
+};
+
+template <>
+struct call_result<void> {
+    template <typename _Fn>
+    auto emplace(_Fn &&fn) -> void {
+        fn();
+    }
+
+    auto take() -> void {}
+};
+
+/* The arguments of inplace_op::call, and where its result goes. */
+template <typename _Ret, typename... _Args>
+struct call_frame {
+    std::tuple<_Args &&...> args;
+    call_result<_Ret> result;
+};
+
+/* The arguments of inplace_op::batch, as invoke_batch takes them. */
+template <typename... _Args>
+struct batch_frame {
+    std::tuple<_Args...> *args;
+    std::size_t n;
+    void *out;
+};
+
+/* The trampoline of an empty inplace_function, of any capacity. */
+template <typename _Ret, typename... _Args>
+inline auto empty_inplace(inplace_op op, void *, void *arg) -> void {
+    if (op == inplace_op::call)
+        throw std::bad_function_call{};
+    if (op == inplace_op::batch && static_cast<batch_frame<_Args...> *>(arg)->n != 0)
+        throw std::bad_function_call{};
+}
+
+} // namespace __detail
+
 struct unsafe {};
 
 inline constexpr unsafe unsafe{};
 
+/* Tag to bind a constant callable, e.g. a function pointer, at compile time. */
+template <auto _Fn>
+struct nontype_t {
+    explicit nontype_t() = default;
+};
+
+template <auto _Fn>
+inline constexpr nontype_t<_Fn> nontype{};
+
 template <class _Ret, class... _Args>
 struct function_view<_Ret(_Args...)> {
 private:
     template <typename _Signature>
     friend struct function_view;
+    template <typename _Signature>
+    friend struct batch_view;
+    template <typename _Signature>
+    friend struct multicast;
 
     using self_t = function_view;
 
@@ -42,27 +185,88 @@ private:
 
     template <can_invoke_with<_Ret, _Args...> _Fn>
         requires(!std::convertible_to<_Fn, raw_t>)
-    static auto _S_make_ptr(_Fn &) -> ptr_t {
-        return [](void *ctx, _Args... args) -> _Ret {
-            return static_cast<_Ret>( // force cast to _Ret
-                (*static_cast<_Fn *>(ctx))(std::forward<_Args>(args)...)
-            );
-        };
-    }
+    static constexpr auto _S_make_ptr = [](void *ctx, _Args... args) -> _Ret {
+        return static_cast<_Ret>( // force cast to _Ret
+            (*static_cast<_Fn *>(ctx))(std::forward<_Args>(args)...)
+        );
+    };
 
-    static auto _S_wrap_raw(raw_t) -> ptr_t {
-        return [](void *ctx, _Args... args) -> _Ret {
-            return static_cast<_Ret>( // force cast to _Ret
-                reinterpret_cast<raw_t>(ctx)(std::forward<_Args>(args)...)
-            );
-        };
-    }
+    static constexpr auto _S_wrap_raw = [](void *ctx, _Args... args) -> _Ret {
+        return static_cast<_Ret>( // force cast to _Ret
+            reinterpret_cast<raw_t>(ctx)(std::forward<_Args>(args)...)
+        );
+    };
 
     template <typename _Fn>
     static auto _S_addr(_Fn &fn) -> void * {
         return std::bit_cast<void *>(std::addressof(fn));
     }
 
+    // the callable is part of the trampoline, so the call is a direct one
+    template <auto _Fn>
+    static constexpr auto _S_bind = [](void *, _Args... args) -> _Ret {
+        return static_cast<_Ret>( // force cast to _Ret
+            std::invoke(_Fn, std::forward<_Args>(args)...)
+        );
+    };
+
+    template <auto _Fn, typename _Up>
+    static constexpr auto _S_bind_to = [](void *ctx, _Args... args) -> _Ret {
+        return static_cast<_Ret>( // force cast to _Ret
+            std::invoke(_Fn, *static_cast<_Up *>(ctx), std::forward<_Args>(args)...)
+        );
+    };
+
+    // each way to make a view, as its trampoline and context; batch_view shares them
+
+    // from non raw pointer unsafely
+
+    template <can_invoke_with<_Ret, _Args...> _Fn>
+        requires(!std::convertible_to<_Fn, raw_t> && !match_decayed<_Fn, self_t>)
+    static auto _S_erase(_Fn &fn) -> __detail::erased<_S_make_ptr<_Fn>> {
+        return {_S_addr(fn)};
+    }
+
+    template <can_invoke_with<_Ret, _Args...> _Fn>
+        requires(!std::convertible_to<_Fn, raw_t> && !match_decayed<_Fn, self_t>)
+    static auto _S_erase(_Fn &&fn, struct unsafe)
+        -> __detail::erased<_S_make_ptr<std::remove_reference_t<_Fn>>> {
+        return {_S_addr(fn)};
+    }
+
+    // from raw pointer safely
+
+    static auto _S_erase(raw_t fn, struct unsafe = {}) -> __detail::erased<_S_wrap_raw> {
+        return {std::bit_cast<void *>(fn)};
+    }
+
+    // bind a constant callable, with no context at all
+
+    template <auto _Fn>
+        requires std::is_invocable_r_v<_Ret, decltype(_Fn), _Args...>
+    static auto _S_erase(nontype_t<_Fn>) -> __detail::erased<_S_bind<_Fn>> {
+        return {nullptr};
+    }
+
+    // bind a constant callable, e.g. a member function pointer, to an object
+
+    template <auto _Fn, typename _Up>
+        requires std::is_invocable_r_v<_Ret, decltype(_Fn), _Up &, _Args...>
+    static auto _S_erase(nontype_t<_Fn>, _Up &obj)
+        -> __detail::erased<_S_bind_to<_Fn, _Up>> {
+        return {_S_addr(obj)};
+    }
+
+    template <auto _Fn, typename _Up>
+        requires std::is_invocable_r_v<_Ret, decltype(_Fn), _Up &, _Args...>
+    static auto _S_erase(nontype_t<_Fn>, _Up *obj)
+        -> __detail::erased<_S_bind_to<_Fn, _Up>> {
+        return {_S_addr(*obj)};
+    }
+
+    template <const auto &_Call>
+    function_view(__detail::erased<_Call> erased) : _M_ptr(_Call), _M_ctx(erased.ctx) {}
+
 public:
     // default constructor
     function_view()  = default;
@@ -74,21 +278,12 @@ public:
 
     function_view(const function_view &rhs, struct unsafe) : function_view(rhs) {}
 
-    // construct from non raw pointer unsafely
+    // from a callable, a raw pointer or nontype<_Fn>, as the _S_erase overloads take
 
-    template <can_invoke_with<_Ret, _Args...> _Fn>
-        requires(!std::convertible_to<_Fn, raw_t> && !match_decayed<_Fn, self_t>)
-    function_view(_Fn &fn) : _M_ptr(_S_make_ptr(fn)), _M_ctx(_S_addr(fn)) {}
-
-    template <can_invoke_with<_Ret, _Args...> _Fn>
-        requires(!std::convertible_to<_Fn, raw_t> && !match_decayed<_Fn, self_t>)
-    function_view(_Fn &&fn, struct unsafe) :
-        _M_ptr(_S_make_ptr(fn)), _M_ctx(_S_addr(fn)) {}
-
-    // construct from raw pointer safely
-
-    function_view(raw_t fn, struct unsafe = {}) :
-        _M_ptr(_S_wrap_raw(fn)), _M_ctx(std::bit_cast<void *>(fn)) {}
+    template <typename... _Init>
+        requires requires(_Init &&...init) { _S_erase(std::forward<_Init>(init)...); }
+    function_view(_Init &&...init) :
+        function_view(_S_erase(std::forward<_Init>(init)...)) {}
 
     auto operator()(_Args &&...args) const -> _Ret {
         return static_cast<_Ret>(_M_ptr(_M_ctx, std::forward<_Args>(args)...));
@@ -99,6 +294,52 @@ private:
     ctx_t _M_ctx{}; // context pointer
 };
 
+// two pointers, passed in registers
+static_assert(sizeof(function_view<int(int)>) == 2 * sizeof(void *));
+
+/**
+ * A function_view called over whole batches of argument tuples: its trampoline
+ * is generated per callable and loops inside, so a batch is one indirect call.
+ * It is made from whatever function_view is made from.
+ */
+template <class _Ret, class... _Args>
+struct batch_view<_Ret(_Args...)> {
+private:
+    using view_t  = function_view<_Ret(_Args...)>;
+    using batch_t = __detail::batch_t<_Ret, _Args...>;
+    using ctx_t   = void *;
+
+    template <const auto &_Call>
+    batch_view(__detail::erased<_Call> erased) :
+        _M_batch(&__detail::invoke_batch<_Call, _Ret, _Args...>), _M_ctx(erased.ctx) {}
+
+public:
+    batch_view() = default;
+
+    template <typename... _Init>
+        requires requires(_Init &&...init) {
+            view_t::_S_erase(std::forward<_Init>(init)...);
+        }
+    batch_view(_Init &&...init) :
+        batch_view(view_t::_S_erase(std::forward<_Init>(init)...)) {}
+
+    auto operator()(std::span<std::tuple<_Args...>> args) const -> void {
+        _M_batch(_M_ctx, args.data(), args.size(), nullptr);
+    }
+
+    auto operator()(std::span<std::tuple<_Args...>> args, std::span<_Ret> out) const
+        -> void
+        requires __detail::batch_result<_Ret>
+    {
+        __detail::check_batch(args.size(), out.size());
+        _M_batch(_M_ctx, args.data(), args.size(), out.data());
+    }
+
+private:
+    batch_t _M_batch{}; // the trampoline, looping over a batch
+    ctx_t _M_ctx{};     // context pointer
+};
+
 template <typename _Fn>
 struct std_function_signature;
 template <typename _Signature>
@@ -115,3 +356,170 @@ function_view(_Fn) -> function_view<std_function_deduce_t<_Fn>>;
 
 template <typename _Fn>
 function_view(_Fn, struct unsafe) -> function_view<std_function_deduce_t<_Fn>>;
+
+template <auto _Fn>
+function_view(nontype_t<_Fn>) -> function_view<std_function_deduce_t<decltype(_Fn)>>;
+
+template <typename _Fn>
+batch_view(_Fn) -> batch_view<std_function_deduce_t<_Fn>>;
+
+template <auto _Fn>
+batch_view(nontype_t<_Fn>) -> batch_view<std_function_deduce_t<decltype(_Fn)>>;
+
+template <class _Signature, std::size_t _Capacity = 4 * sizeof(void *)>
+struct inplace_function;
+
+/**
+ * An owning, move-only function wrapper that never allocates.
+ * The callable lives in _Capacity bytes of inline storage, and a callable
+ * that does not fit is rejected at compile time. One trampoline per callable
+ * calls, batches, moves and destroys it, chosen by an operation code, so the
+ * object is a single pointer and the storage. Calling an empty one throws
+ * std::bad_function_call.
+ */
+template <class _Ret, class... _Args, std::size_t _Capacity>
+struct inplace_function<_Ret(_Args...), _Capacity> {
+private:
+    template <typename _Signature, std::size_t>
+    friend struct inplace_function;
+
+    using self_t = inplace_function;
+
+    using op_t = __detail::inplace_op;
+    // call, batch, move into arg, or destroy the callable at data
+    using ptr_t   = void (*)(op_t, void *data, void *arg);
+    using call_t  = __detail::call_frame<_Ret, _Args...>;
+    using batch_t = __detail::batch_frame<_Args...>;
+
+    static constexpr auto kAlign = alignof(std::max_align_t);
+
+    template <typename _Fn>
+    static constexpr auto _S_make_ptr = [](void *ctx, _Args... args) -> _Ret {
+        return static_cast<_Ret>( // force cast to _Ret
+            (*std::launder(static_cast<_Fn *>(ctx)))(std::forward<_Args>(args)...)
+        );
+    };
+
+    template <typename _Fn>
+    static auto _S_manage(op_t op, void *data, void *arg) -> void {
+        auto *fn = std::launder(static_cast<_Fn *>(data));
+        if (op == op_t::call) [[likely]] {
+            auto &frame = *static_cast<call_t *>(arg);
+            frame.result.emplace([&]() -> _Ret {
+                return std::apply(
+                    [fn](_Args &&...args) -> _Ret {
+                        return static_cast<_Ret>((*fn)(std::forward<_Args>(args)...));
+                    },
+                    std::move(frame.args)
+                );
+            });
+        } else if (op == op_t::batch) {
+            const auto &frame = *static_cast<batch_t *>(arg);
+            __detail::invoke_batch<_S_make_ptr<_Fn>, _Ret, _Args...>(
+                data, frame.args, frame.n, frame.out
+            );
+        } else if (op == op_t::move) {
+            ::new (arg) _Fn(std::move(*fn));
+            std::destroy_at(fn);
+        } else {
+            std::destroy_at(fn);
+        }
+    }
+
+    // shared by every capacity, so that emptiness survives a converting move
+    static constexpr ptr_t _S_empty = &__detail::empty_inplace<_Ret, _Args...>;
+
+public:
+    inplace_function() = default;
+    inplace_function(std::nullptr_t) {}
+
+    inplace_function(const inplace_function &)                     = delete;
+    auto operator=(const inplace_function &) -> inplace_function & = delete;
+
+    template <typename _Fn, typename _Fp = std::decay_t<_Fn>>
+        requires(
+            can_invoke_with<_Fp &, _Ret, _Args...> && !match_decayed<_Fn, self_t> &&
+            std::constructible_from<_Fp, _Fn>
+        )
+    inplace_function(_Fn &&fn) {
+        static_assert(sizeof(_Fp) <= _Capacity, "Callable is too large, raise _Capacity");
+        static_assert(alignof(_Fp) <= kAlign, "Callable is over-aligned");
+        static_assert(
+            std::is_nothrow_move_constructible_v<_Fp>,
+            "Callable must be nothrow move constructible"
+        );
+        ::new (static_cast<void *>(_M_data)) _Fp(std::forward<_Fn>(fn));
+        _M_ptr = &_S_manage<_Fp>;
+    }
+
+    // move, also from one with a smaller capacity
+
+    inplace_function(inplace_function &&rhs) noexcept {
+        this->_M_take(rhs);
+    }
+
+    template <std::size_t _Cap2>
+        requires(_Cap2 < _Capacity)
+    inplace_function(inplace_function<_Ret(_Args...), _Cap2> &&rhs) noexcept {
+        this->_M_take(rhs);
+    }
+
+    auto operator=(inplace_function &&rhs) noexcept -> inplace_function & {
+        if (this != &rhs) {
+            this->_M_reset();
+            this->_M_take(rhs);
+        }
+        return *this;
+    }
+
+    auto operator=(std::nullptr_t) noexcept -> inplace_function & {
+        this->_M_reset();
+        return *this;
+    }
+
+    ~inplace_function() {
+        this->_M_reset();
+    }
+
+    explicit operator bool() const {
+        return _M_ptr != _S_empty;
+    }
+
+    auto operator()(_Args... args) -> _Ret {
+        auto frame = call_t{std::forward_as_tuple(std::forward<_Args>(args)...), {}};
+        _M_ptr(op_t::call, _M_data, &frame);
+        return frame.result.take();
+    }
+
+    // call once per tuple, with a single indirect call for the whole batch
+
+    auto invoke_batch(std::span<std::tuple<_Args...>> args) -> void {
+        auto frame = batch_t{args.data(), args.size(), nullptr};
+        _M_ptr(op_t::batch, _M_data, &frame);
+    }
+
+    auto invoke_batch(std::span<std::tuple<_Args...>> args, std::span<_Ret> out) -> void
+        requires __detail::batch_result<_Ret>
+    {
+        __detail::check_batch(args.size(), out.size());
+        auto frame = batch_t{args.data(), args.size(), out.data()};
+        _M_ptr(op_t::batch, _M_data, &frame);
+    }
+
+private:
+    template <std::size_t _Cap2>
+    auto _M_take(inplace_function<_Ret(_Args...), _Cap2> &rhs) -> void {
+        rhs._M_ptr(op_t::move, rhs._M_data, _M_data);
+        _M_ptr = std::exchange(rhs._M_ptr, _S_empty);
+    }
+
+    auto _M_reset() -> void {
+        std::exchange(_M_ptr, _S_empty)(op_t::destroy, _M_data, nullptr);
+    }
+
+    ptr_t _M_ptr = _S_empty; // the one trampoline, for every operation
+    alignas(kAlign) std::byte _M_data[_Capacity];
+};
+
+template <typename _Fn>
+inplace_function(_Fn) -> inplace_function<std_function_deduce_t<_Fn>>;
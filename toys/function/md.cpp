@@ -0,0 +1,50 @@
+#include "md.h"
+#include <iostream>
+#include <vector>
+
+struct listener {
+    int id;
+    int seen = 0;
+    auto on_event(int value) -> void {
+        seen += value;
+    }
+};
+
+auto main() -> int {
+    auto event     = multicast<void(int)>{};
+    auto listeners = std::vector<listener>{};
+    for (int i = 0; i < 8; ++i)
+        listeners.push_back({.id = i});
+
+    // every listener shares one trampoline, so they form a single group
+    auto handles = std::vector<subscription>{};
+    for (auto &l : listeners)
+        handles.push_back(event.add({nontype<&listener::on_event>, l}));
+
+    auto total   = 0;
+    auto counter = [&total](int value) { total += value; };
+    const auto h = event.add(counter);
+
+    event(1);
+    event.remove(handles[3]);
+    event.remove(handles[5]);
+    event(10);
+    std::cout << "stale remove: " << event.remove(handles[3]) << '\n';
+    event.remove(h);
+    event(100);
+
+    for (const auto &l : listeners)
+        std::cout << l.id << ':' << l.seen << ' ';
+    std::cout << "| total " << total << " | size " << event.size() << '\n';
+
+    // a handle from before a clear must not reach the subscriber in its slot now
+    event.clear();
+    auto fresh     = 0;
+    auto newcomer  = [&fresh](int value) { fresh += value; };
+    const auto h2  = event.add(newcomer);
+    const auto old = event.remove(handles[0]);
+    event(1000);
+    std::cout << "stale remove after clear: " << old << " | fresh " << fresh
+              << " | size " << event.size() << '\n';
+    event.remove(h2);
+}
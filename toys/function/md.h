@@ -0,0 +1,157 @@
+#pragma once
+#include "fv.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+/* Names one subscription, and stays valid while others come and go. */
+struct subscription {
+    std::uint32_t slot;
+    std::uint32_t generation;
+};
+
+/**
+ * A non-owning multicast delegate, in the representation of function_view:
+ * the callables must outlive their subscriptions. Subscribers that share a
+ * trampoline (the same callable type, or the same bound function) form one
+ * group, whose contexts are kept in a contiguous array, so that dispatching
+ * is a tight loop per group. Subscribers are called in no particular order,
+ * and may not be added or removed during a dispatch.
+ */
+template <class... _Args>
+struct multicast<void(_Args...)> {
+private:
+    static_assert(
+        !(std::is_rvalue_reference_v<_Args> || ...),
+        "Arguments are passed to every subscriber, so they cannot be rvalue references"
+    );
+
+    using view_t = function_view<void(_Args...)>;
+    using ptr_t  = typename view_t::ptr_t;
+    using ctx_t  = typename view_t::ctx_t;
+
+    struct group {
+        ptr_t ptr;
+        std::vector<ctx_t> ctxs;          // the hot array, walked by dispatch
+        std::vector<std::uint32_t> slots; // slot of each context, in parallel
+    };
+
+    struct location {
+        std::uint32_t group;
+        std::uint32_t index; // kFree if the slot is not in use
+        std::uint32_t generation;
+    };
+
+    static constexpr auto kFree     = ~std::uint32_t{};
+    static constexpr auto kPrefetch = std::size_t{4}; // contexts to look ahead
+
+public:
+    template <typename _Fn>
+        requires(std::constructible_from<view_t, _Fn &> && !match_decayed<_Fn, view_t>)
+    auto add(_Fn &fn) -> subscription {
+        return this->add(view_t{fn});
+    }
+
+    auto add(view_t view) -> subscription {
+        auto slot = std::uint32_t{};
+        if (_M_free.empty()) {
+            slot = static_cast<std::uint32_t>(_M_where.size());
+            _M_where.push_back({});
+        } else {
+            slot = _M_free.back();
+            _M_free.pop_back();
+        }
+
+        auto index = std::uint32_t{};
+        while (index != _M_groups.size() && _M_groups[index].ptr != view._M_ptr)
+            ++index;
+        if (index == _M_groups.size())
+            _M_groups.push_back({.ptr = view._M_ptr, .ctxs = {}, .slots = {}});
+
+        auto &group = _M_groups[index];
+        auto &where = _M_where[slot];
+        where.group = index;
+        where.index = static_cast<std::uint32_t>(group.ctxs.size());
+        group.ctxs.push_back(view._M_ctx);
+        group.slots.push_back(slot);
+        ++_M_size;
+        return {slot, where.generation};
+    }
+
+    /* Remove a subscription. Returns false if it was already removed. */
+    auto remove(subscription handle) -> bool {
+        if (handle.slot >= _M_where.size())
+            return false;
+        auto &where = _M_where[handle.slot];
+        if (where.index == kFree || where.generation != handle.generation)
+            return false;
+
+        // swap with the last subscriber of the group
+        auto &group      = _M_groups[where.group];
+        const auto moved = group.slots.back();
+
+        group.ctxs[where.index]  = group.ctxs.back();
+        group.slots[where.index] = moved;
+        _M_where[moved].index    = where.index;
+        group.ctxs.pop_back();
+        group.slots.pop_back();
+
+        // and likewise for a group that is left empty
+        if (group.ctxs.empty()) {
+            const auto index = where.group;
+            if (index + 1 != _M_groups.size()) {
+                _M_groups[index] = std::move(_M_groups.back());
+                for (const auto slot : _M_groups[index].slots)
+                    _M_where[slot].group = index;
+            }
+            _M_groups.pop_back();
+        }
+
+        where.index = kFree;
+        ++where.generation;
+        _M_free.push_back(handle.slot);
+        --_M_size;
+        return true;
+    }
+
+    /* Remove every subscription, whose handles stay stale after later adds. */
+    auto clear() -> void {
+        for (const auto &group : _M_groups) {
+            for (const auto slot : group.slots) {
+                _M_where[slot].index = kFree;
+                ++_M_where[slot].generation;
+                _M_free.push_back(slot);
+            }
+        }
+        _M_groups.clear();
+        _M_size = 0;
+    }
+
+    auto size() const -> std::size_t {
+        return _M_size;
+    }
+
+    auto empty() const -> bool {
+        return _M_size == 0;
+    }
+
+    auto operator()(_Args... args) const -> void {
+        for (const auto &group : _M_groups) {
+            const auto ptr  = group.ptr;
+            const auto *ctx = group.ctxs.data();
+            const auto size = group.ctxs.size();
+            for (std::size_t i = 0; i < size; ++i) {
+                if (i + kPrefetch < size)
+                    __builtin_prefetch(ctx[i + kPrefetch]);
+                ptr(ctx[i], args...);
+            }
+        }
+    }
+
+private:
+    std::vector<group> _M_groups;
+    std::vector<location> _M_where; // indexed by slot
+    std::vector<std::uint32_t> _M_free;
+    std::size_t _M_size{};
+};
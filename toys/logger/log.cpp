@@ -0,0 +1,71 @@
+#include "log.h"
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+struct point {
+    int x;
+    double y;
+};
+
+auto main() -> int {
+    constexpr auto kPath    = "/tmp/log_test.txt";
+    constexpr auto kThreads = 4;
+    constexpr auto kCount   = 100000;
+
+    {
+        auto logger = logging::async_logger{kPath};
+        logger.log("tuple: {}, optional: {}", std::tuple{1, 2.5}, std::optional<int>{});
+        logger.log("aggregate: {}", point{1, 2.5});
+        const auto owned = std::string{"owned, past the small buffer"};
+        logger.log("string: {} {}", "literal", owned);
+        // too long for the room left in the slot, so this one goes to the heap
+        logger.log("spilled: {}", std::string(200, '-'));
+
+        auto workers = std::vector<std::jthread>{};
+        for (int t = 0; t < kThreads; ++t) {
+            workers.emplace_back([&logger, t] {
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < kCount; ++i)
+                    logger.log("thread {} record {} value {}", t, i, i * 0.5);
+                const auto stop = std::chrono::steady_clock::now();
+                const auto ns   = std::chrono::duration<double, std::nano>(stop - start);
+                logger.log("thread {}: {} ns per call", t, ns.count() / kCount);
+            });
+        }
+        workers.clear();
+        logger.flush();
+        logger.log("vector: {}", std::vector{1, 2, 3});
+    }
+
+    auto in    = std::ifstream{kPath};
+    auto lines = std::size_t{};
+    for (auto line = std::string{}; std::getline(in, line); ++lines)
+        if (line.starts_with("spilled"))
+            std::cout << "spilled: " << line.size() - 9 << " chars\n";
+        else if (lines < 3 || line.find("ns per call") != std::string::npos ||
+                 line.starts_with("vector"))
+            std::cout << line << '\n';
+    std::cout << "lines: " << lines << '\n';
+
+    // one thread writing to two loggers in turn keeps a ring for each
+    {
+        auto first       = logging::async_logger{"/tmp/log_first.txt"};
+        auto second      = logging::async_logger{"/tmp/log_second.txt"};
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kCount; ++i) {
+            first.log("first {}", i);
+            second.log("second {}", i);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        const auto ns   = std::chrono::duration<double, std::nano>(stop - start);
+        std::cout << "two loggers: " << ns.count() / (2 * kCount) << " ns per call\n";
+    }
+}
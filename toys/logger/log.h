@@ -0,0 +1,421 @@
+#pragma once
+#include "../formatter/fmt.h" // IWYU pragma: keep
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace logging {
+
+namespace __detail {
+
+/* A string argument, its bytes kept in the slot, or on the heap if the slot is full. */
+struct slot_string {
+    std::string_view view;
+    std::unique_ptr<char[]> spill;
+};
+
+} // namespace __detail
+
+/**
+ * How an argument is kept until the background thread formats it.
+ * Strings are copied, since the buffer they point to may be gone by then:
+ * their bytes go into the slot after the other arguments, so only a string
+ * longer than the room left allocates. Specialize for other views.
+ */
+template <typename _Tp>
+struct log_capture {
+    using type = _Tp;
+};
+
+template <>
+struct log_capture<const char *> {
+    using type = __detail::slot_string;
+};
+
+template <>
+struct log_capture<char *> {
+    using type = __detail::slot_string;
+};
+
+template <>
+struct log_capture<std::string_view> {
+    using type = __detail::slot_string;
+};
+
+template <>
+struct log_capture<std::string> {
+    using type = __detail::slot_string;
+};
+
+template <typename _Tp>
+using capture_t = typename log_capture<std::decay_t<_Tp>>::type;
+
+namespace __detail {
+
+inline constexpr auto kCacheLine = std::size_t{64};
+inline constexpr auto kSlotSize  = std::size_t{128};
+
+struct slot {
+    // format the captured arguments into out, then destroy them
+    using fn_t = void (*)(std::string_view, std::byte *, std::string &);
+
+    fn_t fn;
+    std::string_view fmt; // the 24-byte header takes 2 units of max alignment
+    alignas(std::max_align_t) std::byte data[kSlotSize - 2 * alignof(std::max_align_t)];
+};
+
+static_assert(sizeof(slot) == kSlotSize);
+
+// store value as _Capture, a string into the bytes [tail, end) of the slot
+template <typename _Capture, typename _Tp>
+inline auto capture(_Tp &&value, std::byte *&tail, std::byte *end) -> _Capture {
+    if constexpr (std::same_as<_Capture, slot_string>) {
+        const auto view = std::string_view{value};
+        if (view.size() <= static_cast<std::size_t>(end - tail)) {
+            auto *chars = reinterpret_cast<char *>(tail);
+            std::ranges::copy(view, chars);
+            tail += view.size();
+            return slot_string{{chars, view.size()}, nullptr};
+        }
+        auto spill = std::make_unique_for_overwrite<char[]>(view.size());
+        std::ranges::copy(view, spill.get());
+        return slot_string{{spill.get(), view.size()}, std::move(spill)};
+    } else {
+        return _Capture(std::forward<_Tp>(value));
+    }
+}
+
+template <typename _Tp>
+inline auto format_view(const _Tp &value) -> const auto & {
+    if constexpr (std::same_as<_Tp, slot_string>)
+        return value.view;
+    else
+        return value;
+}
+
+template <typename... _Args>
+inline auto format_slot(std::string_view fmt, std::byte *data, std::string &out) -> void {
+    auto *tuple = std::launder(reinterpret_cast<std::tuple<_Args...> *>(data));
+    try {
+        std::apply(
+            [&](auto &...values) {
+                const auto args = std::make_format_args(format_view(values)...);
+                std::vformat_to(std::back_inserter(out), fmt, args);
+            },
+            *tuple
+        );
+    } catch (const std::exception &e) {
+        out.append("<format error: ").append(e.what()).append(">");
+    }
+    out.push_back('\n');
+    std::destroy_at(tuple);
+}
+
+/* Single-producer single-consumer ring of slots, owned by one thread. */
+struct ring {
+public:
+    explicit ring(std::size_t size) :
+        _M_slots(std::bit_ceil(size)), _M_mask(_M_slots.size() - 1) {}
+
+    ring(const ring &)                     = delete;
+    auto operator=(const ring &) -> ring & = delete;
+
+    ~ring() {
+        std::string sink; // drop whatever was never consumed
+        this->consume(sink);
+    }
+
+    template <typename... _Args, typename... _Ts>
+    auto push(std::string_view fmt, _Ts &&...args) -> void {
+        using _Tuple    = std::tuple<_Args...>;
+        const auto tail = _M_tail.load(std::memory_order_relaxed);
+        if (tail - _M_head_cache == _M_slots.size()) [[unlikely]]
+            this->_M_wait_for_room(tail);
+        auto &slot      = _M_slots[tail & _M_mask];
+        auto *rest      = slot.data + sizeof(_Tuple);
+        auto *const end = std::end(slot.data);
+        // braces, so the strings take the room left in order
+        ::new (static_cast<void *>(slot.data))
+            _Tuple{capture<_Args>(std::forward<_Ts>(args), rest, end)...};
+        slot.fn  = &format_slot<_Args...>;
+        slot.fmt = fmt;
+        // seq_cst against the consumer going to sleep, see async_logger
+        _M_tail.store(tail + 1, std::memory_order_seq_cst);
+    }
+
+    /* Format every pending record into out. Only the consumer may call this. */
+    auto consume(std::string &out) -> std::size_t {
+        const auto head = _M_head.load(std::memory_order_relaxed);
+        const auto tail = _M_tail.load(std::memory_order_seq_cst);
+        if (head == tail)
+            return 0;
+        for (auto i = head; i != tail; ++i) {
+            auto &slot = _M_slots[i & _M_mask];
+            slot.fn(slot.fmt, slot.data, out);
+        }
+        _M_head.store(tail, std::memory_order_seq_cst);
+        if (_M_full.load(std::memory_order_seq_cst))
+            _M_head.notify_one();
+        return tail - head;
+    }
+
+    auto pending() const -> bool {
+        const auto tail = _M_tail.load(std::memory_order_seq_cst);
+        return tail != _M_head.load(std::memory_order_relaxed);
+    }
+
+    auto close() -> void {
+        _M_closed.store(true, std::memory_order_release);
+    }
+
+    auto closed() const -> bool {
+        return _M_closed.load(std::memory_order_acquire);
+    }
+
+private:
+    // full: sleep until the consumer frees a slot rather than lose the record
+    auto _M_wait_for_room(std::size_t tail) -> void {
+        // either the consumer sees the flag or this sees its new head
+        _M_full.store(true, std::memory_order_seq_cst);
+        while (tail - (_M_head_cache = _M_head.load(std::memory_order_seq_cst)) ==
+               _M_slots.size())
+            _M_head.wait(_M_head_cache, std::memory_order_seq_cst);
+        _M_full.store(false, std::memory_order_relaxed);
+    }
+
+    std::vector<slot> _M_slots;
+    std::size_t _M_mask;
+    std::atomic<bool> _M_closed{};
+    std::atomic<bool> _M_full{}; // the producer waits for room
+    alignas(kCacheLine) std::atomic<std::size_t> _M_head{}; // written by the consumer
+    alignas(kCacheLine) std::atomic<std::size_t> _M_tail{}; // written by the producer
+    std::size_t _M_head_cache{};                            // producer's view of head
+};
+
+/* The rings of the calling thread, one for each logger it has written to. */
+struct local_rings {
+    struct entry {
+        std::uint64_t owner;
+        std::shared_ptr<ring> ptr;
+    };
+
+    std::vector<entry> entries;
+
+    auto find(std::uint64_t owner) const -> ring * {
+        for (const auto &entry : entries)
+            if (entry.owner == owner)
+                return entry.ptr.get();
+        return nullptr;
+    }
+
+    ~local_rings() {
+        for (const auto &entry : entries)
+            entry.ptr->close();
+    }
+};
+
+inline thread_local local_rings t_local_rings{};
+
+inline auto next_logger_id() -> std::uint64_t {
+    static constinit std::atomic<std::uint64_t> counter{};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+} // namespace __detail
+
+/**
+ * Logger that defers formatting to a background thread.
+ * The calling thread only copies the arguments into its own lock-free ring;
+ * the background thread formats them with std::formatter and writes in batches.
+ * Records of one thread keep their order; records of different threads may not.
+ * The format string must have static storage duration (e.g. a literal).
+ *
+ * With nothing to do, the background thread sleeps on an atomic wait. Before
+ * that it raises a flag and looks at every ring once more; a producer stores
+ * its tail and then reads the flag, all seq_cst, so either the thread sees the
+ * record or the producer sees the flag and wakes it.
+ */
+struct async_logger {
+public:
+    explicit async_logger(const char *path, std::size_t ring_size = 1 << 12) :
+        _M_file(std::fopen(path, "w")), _M_ring_size(ring_size) {
+        if (_M_file == nullptr)
+            throw std::system_error(errno, std::generic_category(), path);
+        _M_thread = std::thread{[this] { this->_M_work(); }};
+    }
+
+    async_logger(const async_logger &)                     = delete;
+    auto operator=(const async_logger &) -> async_logger & = delete;
+
+    ~async_logger() {
+        _M_stop.store(true, std::memory_order_release);
+        this->_M_wake();
+        _M_thread.join();
+        std::fclose(_M_file);
+    }
+
+    template <typename... _Args>
+    auto log(std::format_string<_Args...> fmt, _Args &&...args) -> void {
+        static_assert(
+            sizeof(std::tuple<capture_t<_Args>...>) <= sizeof(__detail::slot::data) &&
+                alignof(std::tuple<capture_t<_Args>...>) <= alignof(std::max_align_t),
+            "Arguments are too large to be captured in a slot"
+        );
+        auto &local = __detail::t_local_rings;
+        auto *ring  = local.find(_M_id);
+        if (ring == nullptr) [[unlikely]]
+            ring = this->_M_attach(local);
+        ring->template push<capture_t<_Args>...>(fmt.get(), std::forward<_Args>(args)...);
+        // the first record after the consumer went to sleep wakes it, once
+        if (_M_sleeping.load(std::memory_order_seq_cst)) [[unlikely]]
+            if (_M_sleeping.exchange(false, std::memory_order_relaxed))
+                this->_M_wake();
+    }
+
+    /* Block until every record logged before this call is written out. */
+    auto flush() -> void {
+        const auto request = _M_flush_request.fetch_add(1, std::memory_order_acq_rel) + 1;
+        this->_M_wake();
+        auto done = _M_flush_done.load(std::memory_order_acquire);
+        while (done < request) {
+            _M_flush_done.wait(done, std::memory_order_acquire);
+            done = _M_flush_done.load(std::memory_order_acquire);
+        }
+    }
+
+private:
+    auto _M_attach(__detail::local_rings &local) -> __detail::ring * {
+        // a ring only this thread still holds belongs to a logger since destroyed
+        std::erase_if(local.entries, [](const auto &entry) {
+            return entry.ptr.use_count() == 1;
+        });
+        auto ptr = std::make_shared<__detail::ring>(_M_ring_size);
+        {
+            const auto guard = std::lock_guard{_M_mutex};
+            _M_rings.push_back(ptr);
+            // seq_cst, so a sleeping consumer misses neither the ring nor its records
+            _M_version.fetch_add(1, std::memory_order_seq_cst);
+        }
+        local.entries.push_back({_M_id, ptr});
+        return ptr.get();
+    }
+
+    auto _M_wake() -> void {
+        _M_wakeups.fetch_add(1, std::memory_order_release);
+        _M_wakeups.notify_one();
+    }
+
+    // sleep until a record, a new ring, a flush or stop comes in
+    auto _M_sleep(
+        const std::vector<std::shared_ptr<__detail::ring>> &rings, std::size_t version
+    ) -> void {
+        const auto seen = _M_wakeups.load(std::memory_order_acquire);
+        _M_sleeping.store(true, std::memory_order_seq_cst);
+        const auto idle = std::ranges::none_of(rings, &__detail::ring::pending) &&
+                          _M_version.load(std::memory_order_seq_cst) == version &&
+                          _M_flush_request.load(std::memory_order_acquire) ==
+                              _M_flush_done.load(std::memory_order_relaxed) &&
+                          !_M_stop.load(std::memory_order_acquire);
+        if (idle)
+            _M_wakeups.wait(seen, std::memory_order_acquire);
+        _M_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    auto _M_drain(std::vector<std::shared_ptr<__detail::ring>> &rings) -> std::size_t {
+        auto count   = std::size_t{};
+        auto removed = std::vector<const __detail::ring *>{};
+        for (auto &ptr : rings) {
+            // a closed ring gets no more records, so it is done once drained
+            const auto closed = ptr->closed();
+            count += ptr->consume(_M_buffer);
+            if (_M_buffer.size() >= kBatchSize)
+                this->_M_write();
+            if (closed)
+                removed.push_back(ptr.get());
+        }
+        if (!removed.empty()) {
+            const auto is_removed = [&removed](const auto &ptr) {
+                return std::ranges::find(removed, ptr.get()) != removed.end();
+            };
+            const auto guard = std::lock_guard{_M_mutex};
+            std::erase_if(_M_rings, is_removed);
+            std::erase_if(rings, is_removed);
+        }
+        return count;
+    }
+
+    auto _M_write() -> void {
+        std::fwrite(_M_buffer.data(), 1, _M_buffer.size(), _M_file);
+        _M_buffer.clear();
+    }
+
+    auto _M_work() -> void {
+        auto rings   = std::vector<std::shared_ptr<__detail::ring>>{};
+        auto version = std::size_t{};
+        while (true) {
+            const auto stop    = _M_stop.load(std::memory_order_acquire);
+            const auto request = _M_flush_request.load(std::memory_order_acquire);
+            if (const auto v = _M_version.load(std::memory_order_acquire); v != version) {
+                const auto guard = std::lock_guard{_M_mutex};
+                version          = _M_version.load(std::memory_order_relaxed);
+                rings            = _M_rings;
+            }
+            const auto count   = this->_M_drain(rings);
+            const auto flushed = request != _M_flush_done.load(std::memory_order_relaxed);
+            this->_M_write();
+            if (count != 0 || flushed)
+                std::fflush(_M_file);
+            if (flushed) {
+                _M_flush_done.store(request, std::memory_order_release);
+                _M_flush_done.notify_all();
+            }
+            if (count == 0) {
+                if (stop)
+                    break;
+                this->_M_sleep(rings, version);
+            }
+        }
+    }
+
+    static constexpr auto kBatchSize = std::size_t{1} << 16;
+
+    std::FILE *_M_file;
+    const std::size_t _M_ring_size;
+    const std::uint64_t _M_id = __detail::next_logger_id();
+
+    std::mutex _M_mutex;
+    std::vector<std::shared_ptr<__detail::ring>> _M_rings;
+    std::atomic<std::size_t> _M_version{};
+
+    std::atomic<bool> _M_stop{};
+    std::atomic<std::size_t> _M_flush_request{};
+    std::atomic<std::size_t> _M_flush_done{};
+    std::atomic<std::uint32_t> _M_wakeups{};
+
+    // read on every log call, so on a line apart from what the consumer writes
+    alignas(__detail::kCacheLine) std::atomic<bool> _M_sleeping{};
+
+    alignas(__detail::kCacheLine) std::string _M_buffer; // only for the background thread
+    std::thread _M_thread; // started last, after every other member
+};
+
+} // namespace logging
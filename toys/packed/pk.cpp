@@ -0,0 +1,46 @@
+#include "pk.h"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+struct wasteful {
+    char tag;
+    double value;
+    std::uint16_t port;
+    std::int64_t stamp;
+    bool valid;
+    std::int32_t count;
+    char level;
+};
+
+struct empty {};
+
+auto main() -> int {
+    using sorted_t = packed::packed_storage<wasteful>;
+    using packed_t = packed::packed_storage<wasteful, packed::layout::packed>;
+
+    static_assert(sizeof(wasteful) == 48);
+    static_assert(sizeof(sorted_t) == 32 && alignof(sorted_t) == 8);
+    static_assert(sizeof(packed_t) == 25 && alignof(packed_t) == 1);
+    static_assert(sizeof(packed::packed_storage<empty>) == 1);
+
+    const auto origin = wasteful{'x', 3.5, 8080, -1, true, 42, 'z'};
+
+    auto sorted = sorted_t{origin};
+    sorted.get<1>() += 1;
+    sorted.set<5>(43);
+
+    auto packed = packed_t{origin};
+    packed.set<0>('y');
+
+    const auto a = sorted.to_value();
+    const auto b = static_cast<wasteful>(packed);
+    std::cout << a.tag << ' ' << a.value << ' ' << a.port << ' ' << a.stamp << ' '
+              << a.valid << ' ' << a.count << ' ' << a.level << '\n';
+    std::cout << b.tag << ' ' << b.value << ' ' << b.port << ' ' << b.stamp << ' '
+              << b.valid << ' ' << b.count << ' ' << b.level << '\n';
+
+    auto table = std::vector<packed_t>(1 << 20, packed_t{origin});
+    std::cout << "table bytes: " << table.size() * sizeof(packed_t) << " instead of "
+              << table.size() * sizeof(wasteful) << '\n';
+}
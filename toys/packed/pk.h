@@ -0,0 +1,178 @@
+#pragma once
+#include "../reflect/rf.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace packed {
+
+enum class layout {
+    sorted, // members reordered by descending alignment, each naturally aligned
+    packed, // members stored back to back with no padding at all, alignment 1
+};
+
+namespace __detail {
+
+template <typename _Tuple>
+struct member_pack;
+
+template <typename... _Args>
+struct member_pack<std::tuple<_Args...>> {
+    using types = std::tuple<std::remove_cvref_t<_Args>...>;
+};
+
+template <typename _Tp>
+using member_types_t =
+    typename member_pack<decltype(reflect::tuplify(std::declval<_Tp &>()))>::types;
+
+inline constexpr auto align_up(std::size_t n, std::size_t align) -> std::size_t {
+    return (n + align - 1) / align * align;
+}
+
+template <layout _Layout, typename _Tuple>
+struct layout_info;
+
+template <layout _Layout, typename... _Args>
+struct layout_info<_Layout, std::tuple<_Args...>> {
+private:
+    static constexpr auto kCount = sizeof...(_Args);
+    static constexpr auto kSizes = std::array<std::size_t, kCount>{sizeof(_Args)...};
+    static constexpr auto kAlign = std::array<std::size_t, kCount>{alignof(_Args)...};
+
+    // storage order, stable so that equally aligned members keep declaration order
+    static constexpr auto kOrder = [] {
+        auto result = std::array<std::size_t, kCount>{};
+        for (std::size_t i = 0; i < kCount; ++i)
+            result[i] = i;
+        if constexpr (_Layout == layout::sorted) {
+            const auto before = [](std::size_t x, std::size_t y) {
+                return kAlign[x] > kAlign[y];
+            };
+            for (std::size_t i = 1; i < kCount; ++i)
+                for (std::size_t j = i; j > 0 && before(result[j], result[j - 1]); --j)
+                    std::swap(result[j - 1], result[j]);
+        }
+        return result;
+    }();
+
+    static constexpr auto kLayout = [] {
+        struct Impl {
+            std::array<std::size_t, kCount> offsets;
+            std::size_t end;
+        };
+        auto result = Impl{};
+        for (const auto i : kOrder) {
+            if constexpr (_Layout == layout::sorted)
+                result.end = align_up(result.end, kAlign[i]);
+            result.offsets[i] = result.end;
+            result.end += kSizes[i];
+        }
+        return result;
+    }();
+
+public:
+    static constexpr auto offsets = kLayout.offsets;
+
+    static constexpr auto align = _Layout == layout::packed
+                                      ? std::size_t{1}
+                                      : std::max({std::size_t{1}, alignof(_Args)...});
+
+    static constexpr auto size = std::max(std::size_t{1}, align_up(kLayout.end, align));
+};
+
+} // namespace __detail
+
+/**
+ * Stores the members of an aggregate _Tp with less padding.
+ * All members must be trivially copyable, as they live in a raw byte buffer.
+ * With layout::packed, members may be misaligned, so get() returns a copy.
+ */
+template <reflect::aggregate_type _Tp, layout _Layout = layout::sorted>
+struct packed_storage {
+private:
+    using _Members = __detail::member_types_t<_Tp>;
+    using _Info    = __detail::layout_info<_Layout, _Members>;
+
+    static constexpr auto kCount = std::tuple_size_v<_Members>;
+
+    template <std::size_t _I>
+    using _Member = std::tuple_element_t<_I, _Members>;
+
+    static_assert(
+        []<std::size_t... _Is>(std::index_sequence<_Is...>) {
+            return (std::is_trivially_copyable_v<_Member<_Is>> && ...);
+        }(std::make_index_sequence<kCount>{}),
+        "All members must be trivially copyable"
+    );
+
+    template <std::size_t _I>
+    auto _M_addr() const -> const std::byte * {
+        return _M_data + _Info::offsets[_I];
+    }
+
+    template <std::size_t _I>
+    auto _M_addr() -> std::byte * {
+        return _M_data + _Info::offsets[_I];
+    }
+
+public:
+    packed_storage() : packed_storage(_Tp{}) {}
+
+    packed_storage(const _Tp &value) {
+        std::apply(
+            [this](const auto &...args) {
+                [&]<std::size_t... _Is>(std::index_sequence<_Is...>) {
+                    (this->set<_Is>(args), ...);
+                }(std::make_index_sequence<kCount>{});
+            },
+            reflect::tuplify(value)
+        );
+    }
+
+    template <std::size_t _I>
+        requires(_I < kCount && _Layout == layout::sorted)
+    auto get() -> _Member<_I> & {
+        return *std::launder(reinterpret_cast<_Member<_I> *>(this->_M_addr<_I>()));
+    }
+
+    template <std::size_t _I>
+        requires(_I < kCount && _Layout == layout::sorted)
+    auto get() const -> const _Member<_I> & {
+        return *std::launder(reinterpret_cast<const _Member<_I> *>(this->_M_addr<_I>()));
+    }
+
+    template <std::size_t _I>
+        requires(_I < kCount && _Layout == layout::packed)
+    auto get() const -> _Member<_I> {
+        auto result = _Member<_I>{};
+        std::memcpy(std::addressof(result), this->_M_addr<_I>(), sizeof(result));
+        return result;
+    }
+
+    template <std::size_t _I>
+        requires(_I < kCount)
+    auto set(const _Member<_I> &value) -> void {
+        std::memcpy(this->_M_addr<_I>(), std::addressof(value), sizeof(value));
+    }
+
+    auto to_value() const -> _Tp {
+        return [this]<std::size_t... _Is>(std::index_sequence<_Is...>) {
+            return reflect::untuplify<_Tp>(_Members{this->get<_Is>()...});
+        }(std::make_index_sequence<kCount>{});
+    }
+
+    explicit operator _Tp() const {
+        return this->to_value();
+    }
+
+private:
+    alignas(_Info::align) std::byte _M_data[_Info::size];
+};
+
+} // namespace packed
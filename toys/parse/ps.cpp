@@ -0,0 +1,59 @@
+#include "ps.h"
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct record {
+    int id;
+    double score;
+    std::string_view name;
+    bool active;
+};
+
+constexpr auto kPath = "/tmp/ps_test.csv";
+
+auto write(std::size_t rows) -> void {
+    std::ofstream out(kPath);
+    out << "id,score,name,active\n";
+    for (std::size_t i = 0; i < rows; ++i)
+        out << i << ',' << i * 0.5 << ",name" << i % 7 << ',' << (i % 3 == 0) << '\n';
+}
+
+} // namespace
+
+auto main() -> int {
+    constexpr auto kRows = std::size_t{1} << 20;
+    write(kRows);
+
+    const auto file = parse::mapped_file{kPath};
+    const auto opt  = parse::options{.delimiter = ',', .has_header = true};
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto rows  = parse::parse_rows<record>(file.view(), opt);
+    const auto stop  = std::chrono::steady_clock::now();
+
+    const auto seconds = std::chrono::duration<double>(stop - start).count();
+    std::cout << "rows: " << rows.size() << ", " << file.view().size() / seconds / 1e6
+              << " MB/s\n";
+    std::cout << rows[3].id << ' ' << rows[3].score << ' ' << rows[3].name << ' '
+              << rows[3].active << '\n';
+
+    const auto columns = parse::parse_columns<record>(file.view(), opt);
+    std::cout << "columns: " << columns.size() << ", last id "
+              << columns.get<0>().back() << '\n';
+
+    const auto line = parse::parse_line<std::tuple<long, char>>("42|x", '|');
+    std::cout << std::get<0>(line) << ' ' << std::get<1>(line) << '\n';
+
+    try {
+        parse::parse_rows<record>("1,2.5,x,1\n2,oops,y,0\n");
+    } catch (const std::invalid_argument &e) {
+        std::cout << e.what() << '\n';
+    }
+}
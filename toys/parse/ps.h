@@ -0,0 +1,328 @@
+#pragma once
+#include "../reflect/rf.h"
+#include <cerrno>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace parse {
+
+/* Specialize this to parse a custom column type from one field of text. */
+template <typename _Tp>
+struct field_parser;
+
+template <typename _Tp>
+concept number_type = (std::integral<_Tp> && !std::same_as<_Tp, bool> &&
+                       !std::same_as<_Tp, char>) ||
+                      std::floating_point<_Tp>;
+
+template <number_type _Tp>
+struct field_parser<_Tp> {
+    static auto from_text(std::string_view text, _Tp &value) -> bool {
+        const auto *last     = text.data() + text.size();
+        const auto [ptr, ec] = std::from_chars(text.data(), last, value);
+        return ec == std::errc{} && ptr == last;
+    }
+};
+
+template <>
+struct field_parser<bool> {
+    static auto from_text(std::string_view text, bool &value) -> bool {
+        if (text == "1" || text == "true")
+            return (value = true, true);
+        if (text == "0" || text == "false")
+            return (value = false, true);
+        return false;
+    }
+};
+
+template <>
+struct field_parser<char> {
+    static auto from_text(std::string_view text, char &value) -> bool {
+        if (text.size() != 1)
+            return false;
+        value = text.front();
+        return true;
+    }
+};
+
+/* Zero-copy: the view points into the source buffer, which must outlive it. */
+template <>
+struct field_parser<std::string_view> {
+    static auto from_text(std::string_view text, std::string_view &value) -> bool {
+        value = text;
+        return true;
+    }
+};
+
+template <>
+struct field_parser<std::string> {
+    static auto from_text(std::string_view text, std::string &value) -> bool {
+        value.assign(text);
+        return true;
+    }
+};
+
+template <typename _Tp>
+concept parsable = requires(std::string_view text, _Tp &value) {
+    { field_parser<_Tp>::from_text(text, value) } -> std::same_as<bool>;
+};
+
+struct options {
+    char delimiter  = ',';
+    bool has_header = false; // skip the first non-empty line
+};
+
+namespace __detail {
+
+template <typename _Tp>
+using member_refs_t = decltype(reflect::tuplify(std::declval<_Tp &>()));
+
+template <typename _Tuple>
+inline constexpr auto all_parsable_v = false;
+
+template <typename... _Args>
+inline constexpr auto all_parsable_v<std::tuple<_Args...>> =
+    (parsable<std::remove_cvref_t<_Args>> && ...);
+
+template <typename _Tuple>
+struct column_tuple;
+
+template <typename... _Args>
+struct column_tuple<std::tuple<_Args...>> {
+    using type   = std::tuple<std::vector<std::remove_cvref_t<_Args>>...>;
+    using values = std::tuple<std::remove_cvref_t<_Args>...>;
+};
+
+inline auto find_char(const char *ptr, const char *end, char c) -> const char * {
+    return static_cast<const char *>(std::memchr(ptr, c, end - ptr));
+}
+
+/* Call fn(line, line_number) for each non-empty line, stripping '\r\n'. */
+template <typename _Fn>
+inline auto for_each_line(std::string_view text, options opt, _Fn &&fn) -> void {
+    const auto *ptr = text.data();
+    const auto *end = ptr + text.size();
+    auto skip       = opt.has_header;
+    for (std::size_t n = 1; ptr != end; ++n) {
+        const auto *next = find_char(ptr, end, '\n');
+        const auto *stop = next ? next : end;
+        auto line        = std::string_view(ptr, stop - ptr);
+        ptr              = next ? next + 1 : end;
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        if (line.empty())
+            continue;
+        if (skip) {
+            skip = false;
+            continue;
+        }
+        fn(line, n);
+    }
+}
+
+/* Split the line by the delimiter and parse field I into std::get<I>(refs). */
+template <typename _Tuple>
+inline auto parse_fields(std::string_view line, char delim, const _Tuple &refs) -> bool {
+    constexpr auto kSize = std::tuple_size_v<_Tuple>;
+    const auto *ptr      = line.data();
+    const auto *end      = ptr + line.size();
+    const auto helper    = [&]<std::size_t _I>(auto &member) -> bool {
+        using _Member    = std::remove_cvref_t<decltype(member)>;
+        const auto *stop = find_char(ptr, end, delim);
+        if constexpr (_I + 1 == kSize) {
+            if (stop != nullptr)
+                return false; // too many fields
+            stop = end;
+        } else {
+            if (stop == nullptr)
+                return false; // too few fields
+        }
+        const auto field = std::string_view(ptr, stop - ptr);
+        ptr              = stop + (stop != end);
+        return field_parser<_Member>::from_text(field, member);
+    };
+    return [&]<std::size_t... _Is>(std::index_sequence<_Is...>) {
+        return (helper.template operator()<_Is>(std::get<_Is>(refs)) && ...);
+    }(std::make_index_sequence<kSize>{});
+}
+
+[[noreturn]]
+inline auto throw_invalid_line(std::size_t n) -> void {
+    throw std::invalid_argument("Invalid field at line " + std::to_string(n));
+}
+
+inline auto count_lines(std::string_view text) -> std::size_t {
+    auto count      = std::size_t{};
+    const auto *ptr = text.data();
+    const auto *end = ptr + text.size();
+    while (const auto *next = find_char(ptr, end, '\n')) {
+        ++count;
+        ptr = next + 1;
+    }
+    return count + (ptr != end);
+}
+
+} // namespace __detail
+
+template <typename _Tp>
+concept row_type = reflect::can_tuplify<_Tp> && std::default_initializable<_Tp> &&
+                   __detail::all_parsable_v<__detail::member_refs_t<_Tp>>;
+
+/* Columnar layout of _Tp: one std::vector per member. */
+template <row_type _Tp>
+struct column_storage {
+private:
+    using _Columns = __detail::column_tuple<__detail::member_refs_t<_Tp>>;
+
+public:
+    using columns_t = typename _Columns::type;
+    using values_t  = typename _Columns::values;
+
+    static constexpr auto column_count = std::tuple_size_v<columns_t>;
+
+    template <std::size_t _I>
+    auto get() -> auto & {
+        return std::get<_I>(_M_columns);
+    }
+
+    template <std::size_t _I>
+    auto get() const -> const auto & {
+        return std::get<_I>(_M_columns);
+    }
+
+    auto size() const -> std::size_t {
+        return _M_size;
+    }
+
+    auto reserve(std::size_t n) -> void {
+        std::apply([n](auto &...column) { (column.reserve(n), ...); }, _M_columns);
+    }
+
+    auto row(std::size_t n) const -> _Tp {
+        return [&]<std::size_t... _Is>(std::index_sequence<_Is...>) {
+            return _Tp{std::get<_Is>(_M_columns)[n]...};
+        }(std::make_index_sequence<column_count>{});
+    }
+
+    auto push_back(values_t &&values) -> void {
+        [&]<std::size_t... _Is>(std::index_sequence<_Is...>) {
+            (std::get<_Is>(_M_columns).push_back(std::get<_Is>(std::move(values))), ...);
+        }(std::make_index_sequence<column_count>{});
+        ++_M_size;
+    }
+
+private:
+    columns_t _M_columns{};
+    std::size_t _M_size{};
+};
+
+template <row_type _Tp>
+inline auto parse_line(std::string_view line, char delim = ',') -> _Tp {
+    auto value = _Tp{};
+    if (!__detail::parse_fields(line, delim, reflect::tuplify(value)))
+        throw std::invalid_argument("Invalid line");
+    return value;
+}
+
+template <row_type _Tp>
+inline auto parse_rows(std::string_view text, options opt = {}) -> std::vector<_Tp> {
+    auto result = std::vector<_Tp>{};
+    result.reserve(__detail::count_lines(text));
+    __detail::for_each_line(text, opt, [&](std::string_view line, std::size_t n) {
+        auto &value = result.emplace_back();
+        if (!__detail::parse_fields(line, opt.delimiter, reflect::tuplify(value)))
+            __detail::throw_invalid_line(n);
+    });
+    return result;
+}
+
+template <row_type _Tp>
+inline auto parse_columns(std::string_view text, options opt = {})
+    -> column_storage<_Tp> {
+    auto result = column_storage<_Tp>{};
+    result.reserve(__detail::count_lines(text));
+    __detail::for_each_line(text, opt, [&](std::string_view line, std::size_t n) {
+        // parse into a local row first, as std::vector<bool> has no bool & to fill
+        auto values = typename column_storage<_Tp>::values_t{};
+        auto refs   = std::apply([](auto &...args) { return std::tie(args...); }, values);
+        if (!__detail::parse_fields(line, opt.delimiter, refs))
+            __detail::throw_invalid_line(n);
+        result.push_back(std::move(values));
+    });
+    return result;
+}
+
+/* A read-only memory mapping of a whole file. */
+struct mapped_file {
+public:
+    explicit mapped_file(const char *path) {
+        const auto fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), path);
+        struct ::stat st{};
+        if (::fstat(fd, &st) != 0) {
+            const auto err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), path);
+        }
+        _M_size = static_cast<std::size_t>(st.st_size);
+        if (_M_size != 0) {
+            auto *ptr = ::mmap(nullptr, _M_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr == MAP_FAILED) {
+                const auto err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), path);
+            }
+            ::madvise(ptr, _M_size, MADV_SEQUENTIAL);
+            _M_data = static_cast<const char *>(ptr);
+        }
+        ::close(fd); // the mapping keeps the file alive
+    }
+
+    mapped_file(mapped_file &&rhs) noexcept :
+        _M_data(std::exchange(rhs._M_data, nullptr)),
+        _M_size(std::exchange(rhs._M_size, 0)) {}
+
+    auto operator=(mapped_file &&rhs) noexcept -> mapped_file & {
+        if (this != &rhs) {
+            this->_M_unmap();
+            _M_data = std::exchange(rhs._M_data, nullptr);
+            _M_size = std::exchange(rhs._M_size, 0);
+        }
+        return *this;
+    }
+
+    ~mapped_file() {
+        this->_M_unmap();
+    }
+
+    auto view() const -> std::string_view {
+        return {_M_data, _M_size};
+    }
+
+private:
+    auto _M_unmap() -> void {
+        if (_M_data != nullptr)
+            ::munmap(const_cast<char *>(_M_data), _M_size);
+    }
+
+    const char *_M_data{};
+    std::size_t _M_size{};
+};
+
+} // namespace parse
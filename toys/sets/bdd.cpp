@@ -0,0 +1,103 @@
+#include "../bench/timing.h"
+#include "bdd.h"
+#include <bitset>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+auto show(const boolean::bdd &f) -> void {
+    std::cout << std::format(", {} nodes, {:.6g} inputs give 1\n", f.size(), f.count());
+}
+
+/* x == y, for words of width bits at inputs x[i] = at(i, 0) and y[i] = at(i, 1). */
+template <typename _At>
+auto equal_words(boolean::bdd_manager &manager, std::size_t width, _At at)
+    -> boolean::bdd {
+    auto result = manager.constant(true);
+    for (std::size_t i = 0; i < width; ++i)
+        result = result & ~(manager.input(at(i, 0)) ^ manager.input(at(i, 1)));
+    return result;
+}
+
+/* At least k of the inputs [0, n) are 1, built from the last input up. */
+auto at_least(boolean::bdd_manager &manager, std::size_t n, std::size_t k)
+    -> boolean::bdd {
+    // rest[j]: at least j of the inputs after the current one
+    auto rest = std::vector<boolean::bdd>(k + 1, manager.constant(false));
+    rest[0]   = manager.constant(true);
+    for (auto i = n; i-- > 0;) {
+        for (auto j = k; j > 0; --j)
+            rest[j] = manager.ite(manager.input(i), rest[j - 1], rest[j]);
+    }
+    return rest[k];
+}
+
+} // namespace
+
+auto main() -> int {
+    auto manager = boolean::bdd_manager{};
+
+    // round trip through a table
+    const auto table = boolean::make_table<6>([](std::bitset<6> b) {
+        return (b[0] && b[1]) != (b[2] || b[5]);
+    });
+    const auto from_table = manager.from_table(table);
+    std::cout << std::format("round trip: {}\n", from_table.to_table<6>() == table);
+
+    std::cout << "64 inputs:\n";
+    const auto eq = measure_once("  x == y, 32 bits interleaved", [&] {
+        return equal_words(manager, 32, [](std::size_t i, std::size_t w) {
+            return 2 * i + w;
+        });
+    });
+    show(eq);
+    const auto half = measure_once("  at least 32 of 64         ", [&] {
+        return at_least(manager, 64, 32);
+    });
+    show(half);
+
+    // the order of the inputs decides the size
+    std::cout << "x == y for 12-bit words, x then y against interleaved:\n";
+    const auto apart = measure_once("  apart      ", [&] {
+        return equal_words(manager, 12, [](std::size_t i, std::size_t w) {
+            return i + 12 * w;
+        });
+    });
+    show(apart);
+    const auto interleaved = measure_once("  interleaved", [&] {
+        return equal_words(manager, 12, [](std::size_t i, std::size_t w) {
+            return 2 * i + w;
+        });
+    });
+    show(interleaved);
+
+    // gather puts functions into the inputs of another
+    const auto gate     = manager.input(0) ^ manager.input(1);
+    const auto composed = gate.gather(eq, half);
+    std::cout << std::format("gather: {}\n", composed == (eq ^ half));
+    std::cout << std::format("support of x == y: {} inputs\n", eq.support().count());
+    std::cout << std::format("manager: {} nodes\n", manager.nodes());
+
+    // a table takes 2^inputs bits, whatever the function
+    std::cout << "parity of 20 inputs:\n";
+    const auto sliced = measure_once("  sliced_table", [] {
+        return boolean::make_sliced<20>([](const auto &x) {
+            auto result = x[0];
+            for (std::size_t i = 1; i < 20; ++i)
+                result = result ^ x[i];
+            return result;
+        });
+    });
+    std::cout << std::format(", {} bytes\n", sliced.words().size_bytes());
+    const auto parity = measure_once("  bdd         ", [&] {
+        auto result = manager.input(0);
+        for (std::size_t i = 1; i < 20; ++i)
+            result = result ^ manager.input(i);
+        return result;
+    });
+    std::cout << std::format(", {} nodes\n", parity.size());
+    std::cout << std::format("same: {}\n", parity.to_sliced<20>() == sliced);
+}
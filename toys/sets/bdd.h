@@ -0,0 +1,417 @@
+#pragma once
+#include "bools.h"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace boolean {
+
+struct bdd_manager;
+
+/**
+ * A boolean function of up to 64 inputs, as a reduced ordered binary decision
+ * diagram: a node of its manager, which tests the inputs in increasing order
+ * and shares every sub-function, so two bdds of one manager are the same
+ * function exactly when they are the same node. Memory grows with the nodes
+ * rather than with 2^inputs, and stays small for adders, comparators,
+ * thresholds and the like. A default bdd holds no function.
+ */
+struct bdd {
+public:
+    bdd() = default;
+
+    auto manager() const -> bdd_manager * {
+        return _M_manager;
+    }
+
+    auto is_constant() const -> bool;
+
+    /* The output for an input: bit i of input is input i. */
+    auto operator()(std::bitset<64> input) const -> bool;
+
+    /* The function with input i fixed to value. */
+    auto restrict(std::size_t i, bool value) const -> bdd;
+
+    /* The function of this(src[0](x), ..., src[n - 1](x), x[n], ...), as gather. */
+    auto gather(std::span<const bdd> src) const -> bdd;
+
+    template <std::same_as<bdd>... _Source>
+    auto gather(const _Source &...src) const -> bdd {
+        const auto list = std::array<bdd, sizeof...(_Source)>{src...};
+        return this->gather(std::span<const bdd>{list});
+    }
+
+    /* The inputs this depends on. */
+    auto support() const -> std::bitset<64>;
+
+    /* The inputs of the first inputs which give 1, as a double. */
+    auto count(std::size_t inputs = 64) const -> double;
+
+    /* The nodes this reaches, terminals included. */
+    auto size() const -> std::size_t;
+
+    /* These require that this depends on none of the inputs past _Inputs. */
+
+    template <std::size_t _Inputs>
+    auto to_sliced() const -> sliced_table<_Inputs>;
+
+    template <std::size_t _Inputs>
+    auto to_table() const -> bool_table<_Inputs> {
+        return this->to_sliced<_Inputs>().to_table();
+    }
+
+    friend auto operator&(const bdd &a, const bdd &b) -> bdd;
+    friend auto operator|(const bdd &a, const bdd &b) -> bdd;
+    friend auto operator^(const bdd &a, const bdd &b) -> bdd;
+    friend auto operator~(const bdd &a) -> bdd;
+
+    friend auto operator==(const bdd &, const bdd &) -> bool = default;
+
+private:
+    friend struct bdd_manager;
+
+    bdd(bdd_manager *manager, std::uint32_t id) : _M_manager(manager), _M_id(id) {}
+
+    // the manager, which a default bdd lacks
+    auto _M_owner() const -> bdd_manager & {
+        if (_M_manager == nullptr)
+            throw std::invalid_argument("BDD without a function");
+        return *_M_manager;
+    }
+
+    bdd_manager *_M_manager = nullptr;
+    std::uint32_t _M_id     = 0;
+};
+
+/**
+ * The nodes of bdds, with a unique table for each input, so each node is made
+ * once, and a computed cache of ite, which keeps 2^cache_bits results, newer
+ * ones replacing older. Nodes live as long as the manager, which can't move
+ * as its bdds point to it.
+ */
+struct bdd_manager {
+public:
+    static constexpr auto kInputs = std::size_t{64};
+
+    explicit bdd_manager(std::size_t cache_bits = 18) {
+        if (cache_bits == 0 || cache_bits > 32)
+            throw std::invalid_argument("Invalid cache size");
+        _M_cache.resize(std::size_t{1} << cache_bits);
+        _M_shift = 64 - cache_bits;
+        _M_nodes.push_back({kLeaf, kFalse, kFalse});
+        _M_nodes.push_back({kLeaf, kTrue, kTrue});
+    }
+
+    bdd_manager(const bdd_manager &)                     = delete;
+    auto operator=(const bdd_manager &) -> bdd_manager & = delete;
+
+    auto constant(bool value) -> bdd {
+        return {this, value ? kTrue : kFalse};
+    }
+
+    /* The function whose output is input i. */
+    auto input(std::size_t i) -> bdd {
+        if (i >= kInputs)
+            throw std::invalid_argument("Input out of range");
+        return {this, this->_M_make(i, kFalse, kTrue)};
+    }
+
+    /* If f then g else h: the apply from which the operators come. */
+    auto ite(const bdd &f, const bdd &g, const bdd &h) -> bdd {
+        this->_M_check(f);
+        this->_M_check(g);
+        this->_M_check(h);
+        return {this, this->_M_ite(f._M_id, g._M_id, h._M_id)};
+    }
+
+    template <std::size_t _Inputs>
+    auto from_table(const bool_table<_Inputs> &table) -> bdd {
+        return {this, this->_M_build(table, 0, 0)};
+    }
+
+    /* The nodes made so far, terminals included. */
+    auto nodes() const -> std::size_t {
+        return _M_nodes.size();
+    }
+
+private:
+    friend struct bdd;
+
+    using id_t = std::uint32_t;
+
+    static constexpr auto kFalse = id_t{0};
+    static constexpr auto kTrue  = id_t{1};
+    static constexpr auto kNone  = std::numeric_limits<id_t>::max();
+    static constexpr auto kLeaf  = std::uint8_t{kInputs}; // after every input
+
+    struct node {
+        std::uint8_t var;
+        id_t lo;
+        id_t hi;
+    };
+
+    struct cache_entry {
+        id_t f = kNone;
+        id_t g = kNone;
+        id_t h = kNone;
+        id_t result;
+    };
+
+    auto _M_check(const bdd &f) const -> void {
+        if (&f._M_owner() != this)
+            throw std::invalid_argument("BDD of another manager");
+    }
+
+    auto _M_var(id_t f) const -> std::size_t {
+        return _M_nodes[f].var;
+    }
+
+    auto _M_cofactor(id_t f, std::size_t var, bool value) const -> id_t {
+        if (_M_nodes[f].var != var)
+            return f;
+        return value ? _M_nodes[f].hi : _M_nodes[f].lo;
+    }
+
+    // the node testing var, reduced: equal branches make no node
+    auto _M_make(std::size_t var, id_t lo, id_t hi) -> id_t {
+        if (lo == hi)
+            return lo;
+        const auto key        = std::uint64_t{lo} << 32 | hi;
+        const auto next       = static_cast<id_t>(_M_nodes.size());
+        const auto [iter, ok] = _M_unique[var].try_emplace(key, next);
+        if (ok) {
+            if (next == kNone)
+                throw std::length_error("Too many BDD nodes");
+            _M_nodes.push_back({static_cast<std::uint8_t>(var), lo, hi});
+        }
+        return iter->second;
+    }
+
+    auto _M_ite(id_t f, id_t g, id_t h) -> id_t {
+        if (f == kTrue)
+            return g;
+        if (f == kFalse)
+            return h;
+        g = g == f ? kTrue : g;
+        h = h == f ? kFalse : h;
+        if (g == h)
+            return g;
+        if (g == kTrue && h == kFalse)
+            return f;
+
+        const auto hash = (std::uint64_t{f} * 0x9E37'79B9'7F4A'7C15u +
+                           std::uint64_t{g} * 0xC2B2'AE3D'27D4'EB4Fu +
+                           std::uint64_t{h} * 0x1656'67B1'9E37'79F9u) >>
+                          _M_shift;
+        auto &entry = _M_cache[hash];
+        if (entry.f == f && entry.g == g && entry.h == h)
+            return entry.result;
+
+        // Shannon expansion on the first input any of them tests
+        const auto var    = std::min({_M_var(f), _M_var(g), _M_var(h)});
+        const auto branch = [&](bool value) {
+            return this->_M_ite(
+                _M_cofactor(f, var, value), _M_cofactor(g, var, value),
+                _M_cofactor(h, var, value)
+            );
+        };
+        const auto hi     = branch(true);
+        const auto lo     = branch(false);
+        const auto result = this->_M_make(var, lo, hi);
+        entry             = {f, g, h, result};
+        return result;
+    }
+
+    template <std::size_t _Inputs>
+    auto _M_build(const bool_table<_Inputs> &table, std::size_t var, std::size_t row)
+        -> id_t {
+        if (var == _Inputs)
+            return table[row] ? kTrue : kFalse;
+        const auto lo = this->_M_build(table, var + 1, row);
+        const auto hi = this->_M_build(table, var + 1, row | std::size_t{1} << var);
+        return this->_M_make(var, lo, hi);
+    }
+
+    // substitute src[v] for each input v < src.size()
+    auto _M_compose(
+        id_t f, std::span<const bdd> src, std::unordered_map<id_t, id_t> &memo
+    ) -> id_t {
+        if (f == kFalse || f == kTrue)
+            return f;
+        if (const auto iter = memo.find(f); iter != memo.end())
+            return iter->second;
+        const auto [var, lo, hi] = _M_nodes[f];
+        const auto new_lo        = this->_M_compose(lo, src, memo);
+        const auto new_hi        = this->_M_compose(hi, src, memo);
+        if (var >= src.size())
+            return memo[f] = this->_M_make(var, new_lo, new_hi);
+        return memo[f] = this->_M_ite(src[var]._M_id, new_hi, new_lo);
+    }
+
+    auto _M_restrict(
+        id_t f, std::size_t i, bool value, std::unordered_map<id_t, id_t> &memo
+    ) -> id_t {
+        if (_M_var(f) > i)
+            return f;
+        if (_M_var(f) == i)
+            return _M_cofactor(f, i, value);
+        if (const auto iter = memo.find(f); iter != memo.end())
+            return iter->second;
+        const auto [var, lo, hi] = _M_nodes[f];
+        const auto new_lo        = this->_M_restrict(lo, i, value, memo);
+        const auto new_hi        = this->_M_restrict(hi, i, value, memo);
+        return memo[f] = this->_M_make(var, new_lo, new_hi);
+    }
+
+    // the nodes f reaches, each once, children before parents
+    auto _M_reach(id_t f) const -> std::vector<id_t> {
+        auto order   = std::vector<id_t>{};
+        auto visited = std::unordered_set<id_t>{};
+        auto stack   = std::vector<std::pair<id_t, bool>>{{f, false}};
+        while (!stack.empty()) {
+            const auto [id, expanded] = stack.back();
+            stack.pop_back();
+            if (expanded) {
+                order.push_back(id);
+            } else if (visited.insert(id).second) {
+                stack.emplace_back(id, true);
+                if (id != kFalse && id != kTrue) {
+                    stack.emplace_back(_M_nodes[id].hi, false);
+                    stack.emplace_back(_M_nodes[id].lo, false);
+                }
+            }
+        }
+        return order;
+    }
+
+    std::vector<node> _M_nodes;
+    std::array<std::unordered_map<std::uint64_t, id_t>, kInputs> _M_unique;
+    std::vector<cache_entry> _M_cache;
+    std::size_t _M_shift = 0;
+};
+
+inline auto bdd::is_constant() const -> bool {
+    return _M_id == bdd_manager::kFalse || _M_id == bdd_manager::kTrue;
+}
+
+inline auto bdd::operator()(std::bitset<64> input) const -> bool {
+    const auto &nodes = this->_M_owner()._M_nodes;
+    auto id           = _M_id;
+    while (nodes[id].var != bdd_manager::kLeaf)
+        id = input[nodes[id].var] ? nodes[id].hi : nodes[id].lo;
+    return id == bdd_manager::kTrue;
+}
+
+inline auto bdd::restrict(std::size_t i, bool value) const -> bdd {
+    auto &manager = this->_M_owner();
+    auto memo     = std::unordered_map<bdd_manager::id_t, bdd_manager::id_t>{};
+    return {&manager, manager._M_restrict(_M_id, i, value, memo)};
+}
+
+inline auto bdd::gather(std::span<const bdd> src) const -> bdd {
+    auto &manager = this->_M_owner();
+    for (const auto &f : src)
+        manager._M_check(f);
+    auto memo = std::unordered_map<bdd_manager::id_t, bdd_manager::id_t>{};
+    return {&manager, manager._M_compose(_M_id, src, memo)};
+}
+
+inline auto bdd::support() const -> std::bitset<64> {
+    const auto &manager = this->_M_owner();
+    auto result         = std::bitset<64>{};
+    for (const auto id : manager._M_reach(_M_id))
+        if (const auto var = manager._M_var(id); var != bdd_manager::kLeaf)
+            result.set(var);
+    return result;
+}
+
+inline auto bdd::count(std::size_t inputs) const -> double {
+    if (inputs < 64 && (this->support() >> inputs).any())
+        throw std::invalid_argument("Function depends on more inputs");
+    // the share of inputs which give 1, from the terminals up
+    const auto &manager = this->_M_owner();
+    auto share          = std::unordered_map<bdd_manager::id_t, double>{};
+    for (const auto id : manager._M_reach(_M_id)) {
+        const auto [var, lo, hi] = manager._M_nodes[id];
+        if (var == bdd_manager::kLeaf)
+            share[id] = id == bdd_manager::kTrue ? 1.0 : 0.0;
+        else
+            share[id] = (share.at(lo) + share.at(hi)) / 2;
+    }
+    return std::ldexp(share[_M_id], static_cast<int>(inputs));
+}
+
+inline auto bdd::size() const -> std::size_t {
+    return this->_M_owner()._M_reach(_M_id).size();
+}
+
+template <std::size_t _Inputs>
+inline auto bdd::to_sliced() const -> sliced_table<_Inputs> {
+    using _Table = sliced_table<_Inputs>;
+    if (_Inputs < 64 && (this->support() >> _Inputs).any())
+        throw std::invalid_argument("Function depends on more inputs");
+    const auto &manager = this->_M_owner();
+    const auto order    = manager._M_reach(_M_id);
+
+    // a table is dropped once the last node above it is built
+    auto parents = std::unordered_map<bdd_manager::id_t, std::size_t>{};
+    for (const auto id : order) {
+        if (const auto [var, lo, hi] = manager._M_nodes[id]; var != bdd_manager::kLeaf) {
+            ++parents[lo];
+            ++parents[hi];
+        }
+    }
+
+    // each node muxes its branches by its input, from the terminals up
+    auto tables        = std::unordered_map<bdd_manager::id_t, _Table>{};
+    const auto release = [&](bdd_manager::id_t id) {
+        if (--parents[id] == 0)
+            tables.erase(id);
+    };
+    for (const auto id : order) {
+        const auto [var, lo, hi] = manager._M_nodes[id];
+        if (var == bdd_manager::kLeaf) {
+            tables.emplace(id, _Table::constant(id == bdd_manager::kTrue));
+        } else {
+            const auto &lo_table = tables.at(lo);
+            const auto x         = lo_table ^ tables.at(hi);
+            tables.emplace(id, lo_table ^ (x & _Table::projection(var)));
+            release(lo);
+            release(hi);
+        }
+    }
+    return std::move(tables.at(_M_id));
+}
+
+inline auto operator&(const bdd &a, const bdd &b) -> bdd {
+    auto &manager = a._M_owner();
+    return manager.ite(a, b, manager.constant(false));
+}
+
+inline auto operator|(const bdd &a, const bdd &b) -> bdd {
+    auto &manager = a._M_owner();
+    return manager.ite(a, manager.constant(true), b);
+}
+
+inline auto operator^(const bdd &a, const bdd &b) -> bdd {
+    auto &manager = a._M_owner();
+    return manager.ite(a, ~b, b);
+}
+
+inline auto operator~(const bdd &a) -> bdd {
+    auto &manager = a._M_owner();
+    return manager.ite(a, manager.constant(false), manager.constant(true));
+}
+
+} // namespace boolean
@@ -0,0 +1,401 @@
+#include "../bench/timing.h"
+#include "bools.h"
+#include "bools_par.h"
+#include "dense.h"
+#include "flat.h"
+#include "sets.h"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <ratio>
+#include <set>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+enum class flags : std::uint64_t {};
+
+inline constexpr auto operator~(flags x) -> flags {
+    return static_cast<flags>(~static_cast<std::uint64_t>(x));
+}
+
+inline constexpr auto operator&(flags x, flags y) -> flags {
+    using _Raw = std::underlying_type_t<flags>;
+    return static_cast<flags>(static_cast<_Raw>(x) & static_cast<_Raw>(y));
+}
+
+template <>
+struct set_op_traits<flags> : std::true_type {
+    static constexpr auto costs = set_costs::uniform(set_cost::constant);
+};
+
+namespace std {
+
+template <typename _Tp>
+inline auto operator&(const std::set<_Tp> &x, const std::set<_Tp> &y) -> std::set<_Tp> {
+    auto result = std::set<_Tp>{};
+    std::ranges::set_intersection(x, y, std::inserter(result, result.end()));
+    return result;
+}
+
+template <typename _Tp>
+inline auto operator^(const std::set<_Tp> &x, const std::set<_Tp> &y) -> std::set<_Tp> {
+    auto result = std::set<_Tp>{};
+    std::ranges::set_symmetric_difference(x, y, std::inserter(result, result.end()));
+    return result;
+}
+
+} // namespace std
+
+template <typename _Tp>
+struct set_op_traits<std::set<_Tp>> : std::true_type {};
+
+constexpr auto kUniverse = 1 << 22;
+
+/* A sorted vector in [0, kUniverse), whose ~ and / must walk the whole universe. */
+struct bounded_set {
+    std::vector<int> values;
+
+    friend auto operator==(const bounded_set &, const bounded_set &) -> bool = default;
+};
+
+template <>
+struct set_op_traits<bounded_set> : std::true_type {
+    static constexpr auto costs =
+        set_costs{.op_sub = set_cost::universe, .op_not = set_cost::universe};
+};
+
+auto operator&(const bounded_set &a, const bounded_set &b) -> bounded_set {
+    auto result = bounded_set{};
+    std::ranges::set_intersection(a.values, b.values, std::back_inserter(result.values));
+    return result;
+}
+
+auto operator^(const bounded_set &a, const bounded_set &b) -> bounded_set {
+    auto result = bounded_set{};
+    std::ranges::set_symmetric_difference(
+        a.values, b.values, std::back_inserter(result.values)
+    );
+    return result;
+}
+
+auto operator~(const bounded_set &a) -> bounded_set {
+    auto result = bounded_set{};
+    result.values.reserve(kUniverse - a.values.size());
+    auto iter = a.values.begin();
+    for (int i = 0; i < kUniverse; ++i) {
+        if (iter != a.values.end() && *iter == i)
+            ++iter;
+        else
+            result.values.push_back(i);
+    }
+    return result;
+}
+
+auto operator/(const bounded_set &a, const bounded_set &b) -> bounded_set {
+    return a & ~b;
+}
+
+namespace {
+
+template <typename _Tp>
+auto describe(std::string_view name) -> void {
+    using _Impl     = __detail::set_op_impl<_Tp>;
+    const auto show = [](std::string_view op, std::size_t plan, const auto &formulas) {
+        const auto text = plan == __detail::kNoPlan ? "-" : formulas[plan];
+        std::cout << "  " << std::left << std::setw(4) << op << text << '\n';
+    };
+    std::cout << name << '\n';
+    show("&", _Impl::plan_and, _Impl::formulas_and);
+    show("|", _Impl::plan_or, _Impl::formulas_or);
+    show("^", _Impl::plan_xor, _Impl::formulas_xor);
+    show("/", _Impl::plan_sub, _Impl::formulas_sub);
+    show("<=>", _Impl::plan_cmp, _Impl::formulas_cmp);
+}
+
+auto random_values(std::size_t n, std::mt19937 &gen) -> std::vector<int> {
+    auto dist   = std::uniform_int_distribution<int>(0, kUniverse - 1);
+    auto values = std::vector<int>(n);
+    for (auto &value : values)
+        value = dist(gen);
+    std::ranges::sort(values);
+    const auto [first, last] = std::ranges::unique(values);
+    values.erase(first, last);
+    return values;
+}
+
+/* The composition row by row, as gather used to evaluate it. */
+template <std::size_t _Inputs>
+auto gather_by_rows(
+    const boolean::bool_table<_Inputs> &table, const boolean::bool_table<_Inputs> &x,
+    const boolean::bool_table<_Inputs> &y
+) -> boolean::bool_table<_Inputs> {
+    return boolean::make_table<_Inputs>([&](std::bitset<_Inputs> input) {
+        auto new_input = std::bitset<_Inputs>{};
+        new_input[0]   = x(input);
+        new_input[1]   = y(input);
+        return table(new_input);
+    });
+}
+
+/* The composition with every input replaced, row by row. */
+template <std::size_t _Inputs>
+auto gather_all_by_rows(
+    const boolean::bool_table<_Inputs> &table,
+    const std::array<boolean::bool_table<_Inputs>, _Inputs> &src
+) -> boolean::bool_table<_Inputs> {
+    return boolean::make_table<_Inputs>([&](std::bitset<_Inputs> input) {
+        auto new_input = std::bitset<_Inputs>{};
+        for (std::size_t i = 0; i < _Inputs; ++i)
+            new_input[i] = src[i](input);
+        return table(new_input);
+    });
+}
+
+auto compare_speed() -> void {
+    constexpr auto kInputs = 14;
+    const auto x = boolean::make_table<kInputs>([](std::bitset<kInputs> b) {
+        return (b[0] && b[3]) || b[7];
+    });
+    const auto y = boolean::make_table<kInputs>([](std::bitset<kInputs> b) {
+        return b[1] != b[13];
+    });
+    const auto gate = boolean::make_table<kInputs>([](std::bitset<kInputs> b) {
+        return b[0] && !b[1];
+    });
+
+    std::cout << "== " << kInputs << " inputs, rows against words ==" << '\n';
+    measure<8>("  make_table", [] {
+        return boolean::make_table<kInputs>([](std::bitset<kInputs> b) {
+                   return (b[0] && b[3]) || (b[7] != b[13]);
+               }).count();
+    });
+    measure<8>("  make_sliced", [] {
+        return boolean::make_sliced<kInputs>([](const auto &b) {
+                   return (b[0] & b[3]) | (b[7] ^ b[13]);
+               }).count();
+    });
+    measure<8>("  gather by rows", [&] { return gather_by_rows(gate, x, y).count(); });
+    measure<8>("  gather by words", [&] { return gate.gather<2>(x, y).count(); });
+
+    using _Sliced = boolean::sliced_table<kInputs>;
+    const auto sx = _Sliced{x};
+    const auto sy = _Sliced{y};
+    const auto sg = _Sliced{gate};
+    measure<8>("  gather, sliced", [&] { return sg.gather<2>(sx, sy).count(); });
+
+    // random tables leave the Shannon expansion nothing to prune
+    auto gen          = std::mt19937{42};
+    const auto random = [&gen] {
+        return boolean::make_table<kInputs>([&gen](auto) { return gen() % 2 == 1; });
+    };
+    const auto table = random();
+    auto sources     = std::array<boolean::bool_table<kInputs>, kInputs>{};
+    for (auto &source : sources)
+        source = random();
+    const auto gather_all = [](const auto &gate, const auto &src) {
+        return std::apply([&](const auto &...x) { return gate.gather(x...); }, src);
+    };
+    std::cout << "  gather all " << kInputs << " inputs matches rows: "
+              << (gather_all(table, sources) == gather_all_by_rows(table, sources))
+              << '\n';
+    measure<8>("  gather all by rows", [&] {
+        return gather_all_by_rows(table, sources).count();
+    });
+    const auto st = _Sliced{table};
+    auto ss       = std::array<_Sliced, kInputs>{};
+    for (std::size_t i = 0; i < kInputs; ++i)
+        ss[i] = _Sliced{sources[i]};
+    measure<8>("  gather all, sliced", [&] { return gather_all(st, ss).count(); });
+    measure<8>("  find_possible_table", [] {
+        using boolean::or_table, boolean::xor_table;
+        return boolean::find_possible_table({or_table, xor_table}).count();
+    });
+}
+
+/* gather where a table is 512 KB, so only a few of them fit on the stack. */
+auto check_large_gather() -> void {
+    constexpr auto kInputs = 22;
+    using _Table           = boolean::bool_table<kInputs>;
+    const auto x = std::make_unique<_Table>(boolean::make_table<kInputs>([](auto b) {
+        return (b[0] && b[11]) || b[21];
+    }));
+    const auto y = std::make_unique<_Table>(boolean::make_table<kInputs>([](auto b) {
+        return b[1] != b[20];
+    }));
+    const auto gate = std::make_unique<_Table>(boolean::make_table<kInputs>([](auto b) {
+        return b[0] && !b[1];
+    }));
+    const auto rows  = std::make_unique<_Table>(gather_by_rows(*gate, *x, *y));
+    const auto words = std::make_unique<_Table>(gate->gather<2>(*x, *y));
+    std::cout << std::format(
+        "  {} inputs, gather by words matches rows: {} ({})\n", kInputs, *rows == *words,
+        words->count()
+    );
+}
+
+template <std::size_t _Inputs, std::size_t _Arity>
+auto explore(std::string_view name, const boolean::bool_table_vec<_Arity> &gates)
+    -> void {
+    const auto label = std::format("  {:<10} {} inputs", name, _Inputs);
+    const auto found = measure_once<std::milli>(label, [&] {
+        return boolean::find_closure<_Inputs>(gates);
+    });
+    const auto all    = std::size_t{1} << (std::size_t{1} << _Inputs);
+    const auto status = found.size() == all ? ", complete" : "";
+    std::cout << std::format(", {:>5} of {:>5}{}\n", found.size(), all, status);
+}
+
+auto explore_gates() -> void {
+    using boolean::make_table;
+    const auto nand = make_table<2>([](std::bitset<2> b) { return !(b[0] && b[1]); });
+    const auto maj  = make_table<3>([](std::bitset<3> b) { return b.count() >= 2; });
+    const auto mux  = make_table<3>([](std::bitset<3> b) {
+        return b.test(2) ? b.test(1) : b.test(0);
+    });
+    const auto xor3 = make_table<3>([](std::bitset<3> b) { return b.count() % 2 == 1; });
+    // x0 ^ (x1 & x2) preserves 0, and 0x98 both constants: their clones stop the search
+    const auto g6a = boolean::bool_table<3>{std::bitset<8>{0x6A}};
+    const auto g98 = boolean::bool_table<3>{std::bitset<8>{0x98}};
+
+    std::cout << "== closures of gate libraries ==" << '\n';
+    explore<3>("nand", boolean::bool_table_vec{nand});
+    explore<4>("nand", boolean::bool_table_vec{nand});
+    explore<3>("and, or", boolean::bool_table_vec{boolean::and_table, boolean::or_table});
+    explore<4>("and, or", boolean::bool_table_vec{boolean::and_table, boolean::or_table});
+    explore<3>("maj", boolean::bool_table_vec{maj});
+    explore<4>("maj", boolean::bool_table_vec{maj});
+    explore<3>("maj, not", boolean::bool_table_vec{maj, boolean::not_table<3>});
+    explore<4>("maj, not", boolean::bool_table_vec{maj, boolean::not_table<3>});
+    explore<3>("mux", boolean::bool_table_vec{mux});
+    explore<3>("mux, not", boolean::bool_table_vec{mux, boolean::not_table<3>});
+    explore<4>("mux, not", boolean::bool_table_vec{mux, boolean::not_table<3>});
+    explore<4>("xor3", boolean::bool_table_vec{xor3});
+    explore<4>("0x6a", boolean::bool_table_vec{g6a});
+    explore<4>("0x98", boolean::bool_table_vec{g98});
+}
+
+auto compare_parallel() -> void {
+    // every pair of the 16 functions of 2 inputs, over 3 inputs
+    auto libraries = std::vector<boolean::bool_table_vec<2>>{};
+    for (unsigned long x = 0; x < 16; ++x)
+        for (unsigned long y = x; y < 16; ++y)
+            libraries.push_back({std::bitset<4>{x}, std::bitset<4>{y}});
+
+    const auto maj = boolean::make_table<3>([](std::bitset<3> b) {
+        return b.count() >= 2;
+    });
+    const auto maj_not = boolean::bool_table_vec{maj, boolean::not_table<3>};
+
+    const auto threads = std::thread::hardware_concurrency();
+    std::cout << "== serial against parallel, " << threads << " hardware threads =="
+              << '\n';
+    const auto report = [](std::size_t total) {
+        std::cout << std::format(" ({})\n", total);
+    };
+    report(measure_once<std::milli>("  136 pairs, 3 inputs, serial  ", [&] {
+        auto total = std::size_t{};
+        for (const auto &gates : libraries)
+            total += boolean::find_closure<3>(gates).size();
+        return total;
+    }));
+    report(measure_once<std::milli>("  136 pairs, 3 inputs, parallel", [&] {
+        auto total = std::size_t{};
+        for (const auto &closure : boolean::parallel_closures<3>(libraries))
+            total += closure.size();
+        return total;
+    }));
+    report(measure_once<std::milli>("  maj, not, 4 inputs, serial   ", [&] {
+        return boolean::find_closure<4>(maj_not).size();
+    }));
+    report(measure_once<std::milli>("  maj, not, 4 inputs, parallel ", [&] {
+        return boolean::parallel_closure<4>(maj_not).size();
+    }));
+}
+
+} // namespace
+
+auto main() -> int {
+    std::cout << "== formulas chosen by the cost model ==" << '\n';
+    describe<flags>("enum flags: & ~, O(1)");
+    describe<dense_bitset<1 << 16>>("dense_bitset: & | ^ ~, O(universe), fused");
+    describe<std::set<int>>("std::set: & ^, O(n)");
+    describe<flat_set<int>>("flat_set: & | ^ /, O(n), fused");
+    describe<bounded_set>("bounded_set: & ^ O(n), / ~ O(universe)");
+
+    auto gen      = std::mt19937{42};
+    const auto va = random_values(1 << 16, gen);
+    const auto vb = random_values(1 << 16, gen);
+    const auto a  = bounded_set{va};
+    const auto b  = bounded_set{vb};
+    const auto sa = std::set<int>(va.begin(), va.end());
+    const auto sb = std::set<int>(vb.begin(), vb.end());
+    auto da       = dense_bitset<1 << 16>{};
+    auto db       = dense_bitset<1 << 16>{};
+    for (const auto x : va)
+        da.insert(static_cast<std::size_t>(x) % (1 << 16));
+    for (const auto x : vb)
+        db.insert(static_cast<std::size_t>(x) % (1 << 16));
+
+    std::cout << "== bounded_set, 65536 ids in a universe of 4M ==" << '\n';
+    measure<8>("  a | b (cost model)", [&] { return (a | b).values.size(); });
+    measure<8>("  (a / b) ^ b (by order)", [&] { return ((a / b) ^ b).values.size(); });
+    measure<8>("  a <=> b (cost model)", [&] { return std::size_t{a <= b}; });
+
+    std::cout << "== std::set ==" << '\n';
+    measure<8>("  a | b", [&] { return (sa | sb).size(); });
+    measure<8>("  a / b", [&] { return (sa / sb).size(); });
+
+    std::cout << "== dense_bitset<65536> ==" << '\n';
+    measure<8>("  a / b (fused)", [&] { return (da / db).count(); });
+    measure<8>("  (a & b) ^ a (by order)", [&] { return ((da & db) ^ da).count(); });
+
+    // the union of many sets, as a fresh set per step or in place
+    auto parts = std::vector<flat_set<int>>{};
+    auto bits  = std::vector<dense_bitset<1 << 16>>(256);
+    for (std::size_t i = 0; i < 256; ++i) {
+        parts.emplace_back(random_values(1 << 10, gen));
+        for (const auto x : parts.back())
+            bits[i].insert(static_cast<std::size_t>(x) % (1 << 16));
+    }
+    std::cout << "== union of 256 sets ==" << '\n';
+    measure<8>("  flat_set acc = acc | s", [&] {
+        auto acc = flat_set<int>{};
+        for (const auto &part : parts)
+            acc = acc | part;
+        return acc.size();
+    });
+    measure<8>("  flat_set acc |= s", [&] {
+        auto acc = flat_set<int>{};
+        for (const auto &part : parts)
+            acc |= part;
+        return acc.size();
+    });
+    measure<8>("  dense_bitset acc = acc | s", [&] {
+        auto acc = dense_bitset<1 << 16>{};
+        for (const auto &part : bits)
+            acc = acc | part;
+        return acc.count();
+    });
+    measure<8>("  dense_bitset acc |= s", [&] {
+        auto acc = dense_bitset<1 << 16>{};
+        for (const auto &part : bits)
+            acc |= part;
+        return acc.count();
+    });
+
+    compare_speed();
+    check_large_gather();
+    explore_gates();
+    compare_parallel();
+}
@@ -1,4 +1,7 @@
 #include "bools.h"
+#include "bools_par.h"
+#include <bitset>
+#include <cstddef>
 #include <format>
 #include <iostream>
 #include <map>
@@ -47,29 +50,37 @@ auto main() -> int {
 
     // dispatch(pretty_print);
 
-    auto test_cope = [&](boolean::bool_table<2> x, boolean::bool_table<2> y) {
-        auto possible = boolean::find_possible_table({x, y});
-        tmp_result    = possible;
-        dispatch(pretty_print.template operator()<false>);
-    };
+    // every pair of gates, whose closures are found in parallel
+    auto pair_names = std::vector<std::pair<std::string_view, std::string_view>>{};
+    auto libraries  = std::vector<boolean::bool_table_vec<2>>{};
 
     auto loop_cope = [&](boolean::bool_table<2> x, std::string_view name_x) {
         auto lambda = [&](boolean::bool_table<2> y, std::string_view name_y) {
             if (x.to_ulong() > y.to_ulong())
                 return;
-            std::cout << std::format("case: {} and {}\n", name_x, name_y);
-            possible_names.clear();
-            test_cope(x, y);
-            for (auto &&name : possible_names)
-                if (name != name_x && name != name_y)
-                    can_from_pairs[name].emplace_back(name_x, name_y);
-            std::cout << '\n';
+            pair_names.emplace_back(name_x, name_y);
+            libraries.push_back({x, y});
         };
         dispatch(lambda);
     };
+    dispatch(loop_cope);
+
+    const auto closures = boolean::parallel_closures<2>(libraries);
 
     auto *ptr = std::cout.rdbuf(nullptr);
-    dispatch(loop_cope);
+    for (std::size_t k = 0; k < closures.size(); ++k) {
+        const auto &[name_x, name_y] = pair_names[k];
+        std::cout << std::format("case: {} and {}\n", name_x, name_y);
+        possible_names.clear();
+        tmp_result.reset();
+        for (const auto &table : closures[k])
+            tmp_result.set(table.words()[0]);
+        dispatch(pretty_print.template operator()<false>);
+        for (auto &&name : possible_names)
+            if (name != name_x && name != name_y)
+                can_from_pairs[name].emplace_back(name_x, name_y);
+        std::cout << '\n';
+    }
     std::cout.rdbuf(ptr);
 
     for (auto &&[name, pairs] : can_from_pairs) {
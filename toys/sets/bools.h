@@ -1,13 +1,20 @@
 #pragma once
+#include "dense.h"
 #include <algorithm>
 #include <array>
 #include <bit>
 #include <bitset>
+#include <compare>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
+#include <limits>
+#include <span>
 #include <tuple>
+#include <type_traits>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -16,6 +23,9 @@ namespace boolean {
 template <std::size_t _Inputs>
 struct bool_table;
 
+template <std::size_t _Inputs>
+struct sliced_table;
+
 template <typename _Tp>
 inline constexpr auto is_bool_table_v = false;
 
@@ -45,18 +55,305 @@ struct bool_table : std::bitset<1zu << _Inputs> {
         return (*this)[input.to_ulong()];
     }
 
+    /* The table of this(src[0](x), ..., src[_Target - 1](x)), composed word-wise. */
     template <std::size_t _Target = _Inputs, bool_table_type... _Source>
-    constexpr auto gather(const _Source &...src) -> bool_table {
-        return make_table<_Inputs>([&](std::bitset<_Inputs> input) {
-            auto new_input = std::bitset<_Inputs>{};
-            [&]<std::size_t... _Is>(std::index_sequence<_Is...>) {
-                ((new_input[_Is] = src(input)), ...);
-            }(std::make_index_sequence<_Target>{});
-            return (*this)(new_input);
-        });
+    constexpr auto gather(const _Source &...src) const -> bool_table {
+        using _Sliced = sliced_table<_Inputs>;
+        return _Sliced{*this}.template gather<_Target>(_Sliced{src}...).to_table();
     }
 };
 
+namespace __detail {
+
+using set_operation::__detail::apply_word;
+using set_operation::__detail::bit_apply;
+using set_operation::__detail::bit_op;
+using set_operation::__detail::word_t;
+
+// input i over the 64 rows of one word, for i < 6
+inline constexpr auto kProjections = std::array<word_t, 6>{
+    0xAAAA'AAAA'AAAA'AAAA, 0xCCCC'CCCC'CCCC'CCCC, 0xF0F0'F0F0'F0F0'F0F0,
+    0xFF00'FF00'FF00'FF00, 0xFFFF'0000'FFFF'0000, 0xFFFF'FFFF'0000'0000,
+};
+
+/* A 64 x 64 bit transpose in place: bit j of word i trades with bit i of word j. */
+constexpr auto transpose(std::array<word_t, 64> &words) -> void {
+    // swap the high half of each block of word j with the low half of word j + width
+    auto mask = word_t{0x0000'0000'FFFF'FFFF};
+    for (std::size_t width = 32; width != 0; width /= 2, mask ^= mask << width) {
+        for (std::size_t k = 0; k < 32; ++k) {
+            // j has bit width clear
+            const auto j    = (k & ~(width - 1)) * 2 + (k & (width - 1));
+            const auto swap = ((words[j] >> width) ^ words[j + width]) & mask;
+            words[j] ^= swap << width;
+            words[j + width] ^= swap;
+        }
+    }
+}
+
+} // namespace __detail
+
+/**
+ * A truth table in 64-row words: bit r % 64 of word r / 64 is the output for
+ * the input r, as row r of bool_table. Tables compose with whole-word &, |, ^
+ * and ~, which use AVX-512 or AVX2 at run time when the target supports them.
+ * Past a few cache lines the words live on the heap, 2 MB at 24 inputs.
+ */
+template <std::size_t _Inputs>
+struct sliced_table {
+    static_assert(_Inputs <= 24 && _Inputs > 0, "Too many inputs");
+
+private:
+    using word_t = __detail::word_t;
+    using bit_op = __detail::bit_op;
+
+public:
+    static constexpr auto kRows  = std::size_t{1} << _Inputs;
+    static constexpr auto kWords = (kRows + 63) / 64;
+
+    // the rows in use, as fewer than 6 inputs fill only part of the word
+    static constexpr auto kMask = kRows >= 64 ? ~word_t{} : (word_t{1} << kRows) - 1;
+
+private:
+    // bit r of a std::bitset is bit r % 8 of its byte r / 8 on little-endian targets
+    static constexpr auto kLineWords = std::size_t{8}; // words in a cache line
+
+    static constexpr auto kSameLayout =
+        std::endian::native == std::endian::little &&
+        std::is_trivially_copyable_v<std::bitset<kRows>> &&
+        sizeof(std::bitset<kRows>) == sizeof(word_t) * kWords;
+
+    // gather keeps a table per level of its recursion, so large ones stay off the stack
+    static constexpr auto kInline = kWords <= 4 * kLineWords;
+
+    using _Words = std::conditional_t<
+        kInline, std::array<word_t, kWords>, std::vector<word_t>>;
+
+public:
+    constexpr sliced_table() = default;
+
+    constexpr explicit sliced_table(const bool_table<_Inputs> &table) {
+        if constexpr (kRows <= 64) {
+            _M_words[0] = table.to_ullong();
+        } else {
+            if !consteval {
+                if constexpr (kSameLayout) {
+                    const auto &bits = static_cast<const std::bitset<kRows> &>(table);
+                    std::memcpy(_M_words.data(), &bits, sizeof(bits));
+                    return;
+                }
+            }
+            for (std::size_t r = 0; r < kRows; ++r)
+                _M_words[r / 64] |= word_t{table[r]} << (r % 64);
+        }
+    }
+
+    constexpr auto to_table() const -> bool_table<_Inputs> {
+        auto table = bool_table<_Inputs>{};
+        if constexpr (kRows <= 64) {
+            table = std::bitset<kRows>{_M_words[0]};
+        } else {
+            if !consteval {
+                if constexpr (kSameLayout) {
+                    void *bits = &static_cast<std::bitset<kRows> &>(table);
+                    std::memcpy(bits, _M_words.data(), sizeof(word_t) * kWords);
+                    return table;
+                }
+            }
+            for (std::size_t r = 0; r < kRows; ++r)
+                table[r] = (*this)[r];
+        }
+        return table;
+    }
+
+    static constexpr auto constant(bool value) -> sliced_table {
+        auto result = sliced_table{};
+        if (value)
+            std::ranges::fill(result._M_words, kMask);
+        return result;
+    }
+
+    /* The table whose output is input i: 0xAAAA..., 0xCCCC... and so on. */
+    static constexpr auto projection(std::size_t i) -> sliced_table {
+        auto result = sliced_table{};
+        if (i < 6)
+            std::ranges::fill(result._M_words, __detail::kProjections[i] & kMask);
+        else
+            for (std::size_t w = 0; w < kWords; ++w)
+                result._M_words[w] = (w >> (i - 6)) & 1 ? ~word_t{} : word_t{};
+        return result;
+    }
+
+    constexpr auto operator[](std::size_t row) const -> bool {
+        return (_M_words[row / 64] >> (row % 64)) & 1;
+    }
+
+    constexpr auto operator()(std::bitset<_Inputs> input) const -> bool {
+        return (*this)[input.to_ullong()];
+    }
+
+    constexpr auto count() const -> std::size_t {
+        auto total = std::size_t{};
+        for (const auto word : _M_words)
+            total += static_cast<std::size_t>(std::popcount(word));
+        return total;
+    }
+
+    constexpr auto words() const -> std::span<const word_t, kWords> {
+        return std::span<const word_t, kWords>{_M_words.data(), kWords};
+    }
+
+    /* The table with input i negated: its row r is row r ^ 2^i of this. */
+    constexpr auto flip(std::size_t i) const -> sliced_table {
+        auto result = sliced_table{};
+        if (i < 6) {
+            // rows r and r ^ 2^i share a word, as bits 2^i apart
+            const auto hi    = __detail::kProjections[i];
+            const auto shift = std::size_t{1} << i;
+            for (std::size_t w = 0; w < kWords; ++w) {
+                const auto word    = _M_words[w];
+                result._M_words[w] = ((word & hi) >> shift) | ((word << shift) & hi);
+            }
+        } else {
+            const auto stride = std::size_t{1} << (i - 6);
+            for (std::size_t w = 0; w < kWords; ++w)
+                result._M_words[w] = _M_words[w ^ stride];
+        }
+        return result;
+    }
+
+    /* The table of this(src[0](x), ..., src[_Target - 1](x)), as bool_table::gather. */
+    template <std::size_t _Target = _Inputs, std::same_as<sliced_table>... _Source>
+        requires(sizeof...(_Source) == _Target && _Target <= _Inputs)
+    constexpr auto gather(const _Source &...src) const -> sliced_table {
+        const auto sources = std::array<const sliced_table *, _Target>{&src...};
+        // the expansion muxes up to 2^_Target times, a lookup costs about _Target per row
+        if constexpr ((std::size_t{1} << _Target) * kWords < kRows * _Target)
+            return this->_M_select(sources, _Target, 0);
+        else
+            return this->_M_lookup(sources);
+    }
+
+    friend constexpr auto operator&(const sliced_table &a, const sliced_table &b)
+        -> sliced_table {
+        return _S_apply<bit_op::bit_and>(a, b);
+    }
+
+    friend constexpr auto operator|(const sliced_table &a, const sliced_table &b)
+        -> sliced_table {
+        return _S_apply<bit_op::bit_or>(a, b);
+    }
+
+    friend constexpr auto operator^(const sliced_table &a, const sliced_table &b)
+        -> sliced_table {
+        return _S_apply<bit_op::bit_xor>(a, b);
+    }
+
+    friend constexpr auto operator~(const sliced_table &a) -> sliced_table {
+        auto result = _S_apply<bit_op::bit_not>(a, a);
+        if constexpr (kRows < 64)
+            result._M_words[0] &= kMask;
+        return result;
+    }
+
+    friend constexpr auto operator==(const sliced_table &, const sliced_table &)
+        -> bool = default;
+
+    friend constexpr auto operator<=>(const sliced_table &, const sliced_table &)
+        -> std::strong_ordering = default;
+
+private:
+    template <bit_op _Op>
+    static constexpr auto _S_apply(const sliced_table &a, const sliced_table &b)
+        -> sliced_table {
+        auto result = sliced_table{};
+        if !consteval {
+            // a few words are cheaper inline than through the SIMD dispatch
+            if constexpr (kWords >= kLineWords) {
+                __detail::bit_apply<_Op>(
+                    result._M_words.data(), a._M_words.data(), b._M_words.data(), kWords
+                );
+                return result;
+            }
+        }
+        for (std::size_t i = 0; i < kWords; ++i)
+            result._M_words[i] = __detail::apply_word<_Op>(a._M_words[i], b._M_words[i]);
+        return result;
+    }
+
+    // whether rows [base, base + 2^k) of this are all 0 or all 1
+    constexpr auto _M_uniform(std::size_t k, std::size_t base) const -> bool {
+        if (k < 6) {
+            const auto mask = (word_t{1} << (std::size_t{1} << k)) - 1;
+            const auto bits = (_M_words[base / 64] >> (base % 64)) & mask;
+            return bits == 0 || bits == mask;
+        }
+        const auto first = _M_words[base / 64];
+        const auto last  = base / 64 + (std::size_t{1} << (k - 6));
+        if (first != 0 && first != ~word_t{})
+            return false;
+        for (std::size_t w = base / 64; w != last; ++w)
+            if (_M_words[w] != first)
+                return false;
+        return true;
+    }
+
+    // Shannon expansion: rows [base, base + 2^k) of this, chosen by src[0, k)
+    template <std::size_t _Nm>
+    constexpr auto _M_select(
+        const std::array<const sliced_table *, _Nm> &src, std::size_t k, std::size_t base
+    ) const -> sliced_table {
+        if (this->_M_uniform(k, base))
+            return constant((*this)[base]);
+        auto result   = this->_M_select(src, k - 1, base);
+        const auto hi = this->_M_select(src, k - 1, base | std::size_t{1} << (k - 1));
+        result._M_mux(hi, *src[k - 1]);
+        return result;
+    }
+
+    // row by row: transpose the sources' words into the rows of this to look up
+    template <std::size_t _Nm>
+    constexpr auto _M_lookup(const std::array<const sliced_table *, _Nm> &src) const
+        -> sliced_table {
+        auto result = sliced_table{};
+        auto rows   = std::array<word_t, 64>{};
+        for (std::size_t w = 0; w < kWords; ++w) {
+            for (std::size_t i = 0; i < 64; ++i)
+                rows[i] = i < _Nm ? src[i]->_M_words[w] : word_t{};
+            __detail::transpose(rows);
+            auto word = word_t{};
+            for (std::size_t j = 0; j < 64; ++j)
+                word |= static_cast<word_t>((*this)[rows[j]]) << j;
+            result._M_words[w] = word & kMask;
+        }
+        return result;
+    }
+
+    // hi where the input is 1, else this, in place
+    constexpr auto _M_mux(const sliced_table &hi, const sliced_table &input) -> void {
+        for (std::size_t w = 0; w < kWords; ++w)
+            _M_words[w] ^= (_M_words[w] ^ hi._M_words[w]) & input._M_words[w];
+    }
+
+    static constexpr auto _S_zeros() -> _Words {
+        if constexpr (kInline)
+            return _Words{};
+        else
+            return _Words(kWords);
+    }
+
+    _Words _M_words = _S_zeros();
+};
+
+/* Build a table from fn(x), where x[i] is the table of input i, in whole words. */
+template <std::size_t _Len, typename _Fn>
+constexpr auto make_sliced(_Fn &&fn) -> sliced_table<_Len> {
+    auto inputs = std::array<sliced_table<_Len>, _Len>{};
+    for (std::size_t i = 0; i < _Len; ++i)
+        inputs[i] = sliced_table<_Len>::projection(i);
+    return fn(std::as_const(inputs));
+}
+
 template <std::size_t _Inputs>
 struct bool_table_vec : std::vector<bool_table<_Inputs>> {
     using std::vector<bool_table<_Inputs>>::vector;
@@ -90,50 +387,316 @@ inline constexpr auto map_table =
 
 inline constexpr auto find_possible_table(bool_table_vec<2> inputs)
     -> std::bitset<1 << (1 << 2)> {
-    // a combination to find all possible tables
+    // a combination to find all possible tables, each held in one word
+    using _Table = sliced_table<2>;
+
     auto possible_table = bool_table<(1 << 2)>{};
-    auto history_tables = std::bitset<(1 << 2) << (1 << 2)>{};
+    auto history_tables = std::array<_Table, 1 << (1 << 2)>{};
     auto table_count    = 0zu;
 
     bool changed = false;
 
-    auto get_nth_table = [&](std::size_t n) {
-        auto table = std::bitset<1 << 2>{};
-        for (int i = 0; i < 1 << 2; ++i)
-            table[i] = history_tables[n << 2 | i];
-        return bool_table<2>{table};
-    };
-    auto add_new_table = [&](std::bitset<1 << 2> table) {
-        if (possible_table[table.to_ulong()])
+    auto add_new_table = [&](const _Table &table) {
+        const auto index = static_cast<std::size_t>(table.words()[0]);
+        if (possible_table[index])
             return;
-        changed      = true;
-        const auto n = table_count;
-        table_count  = n + 1;
-        for (int i = 0; i < 1 << 2; ++i)
-            history_tables[n << 2 | i] = table[i];
-        possible_table[table.to_ulong()] = true;
+        changed                     = true;
+        history_tables[table_count] = table;
+        table_count                 = table_count + 1;
+        possible_table[index]       = true;
     };
 
     // basic identity tables
-    add_new_table(map_table<2, 0>);
-    add_new_table(map_table<2, 1>);
+    add_new_table(_Table::projection(0));
+    add_new_table(_Table::projection(1));
 
     // to speed up the iteration
-    for (auto &table : inputs)
-        add_new_table(table);
+    auto gates = std::vector<_Table>{};
+    for (auto &table : inputs) {
+        gates.emplace_back(table);
+        add_new_table(gates.back());
+    }
 
     do {
         changed = false;
         for (std::size_t i = 0; i < table_count; ++i) {
-            const auto table_x = get_nth_table(i);
+            const auto table_x = history_tables[i];
             for (std::size_t j = 0; j < table_count; ++j) {
-                const auto table_y = get_nth_table(j);
-                for (auto &table : inputs)
-                    add_new_table(table.gather(table_x, table_y));
+                const auto table_y = history_tables[j];
+                for (auto &gate : gates)
+                    add_new_table(gate.gather(table_x, table_y));
             }
         }
     } while (changed);
     return possible_table;
 }
 
+namespace __detail {
+
+/* The tables found so far: one bit per function up to 4 inputs, else a hash set. */
+template <std::size_t _Inputs>
+struct seen_tables {
+private:
+    using _Table = sliced_table<_Inputs>;
+
+    struct hash {
+        auto operator()(const _Table &table) const -> std::size_t {
+            auto seed = std::size_t{};
+            for (const auto word : table.words())
+                seed = (seed ^ word) * 0x9E37'79B9'7F4A'7C15;
+            return seed ^ (seed >> 32);
+        }
+    };
+
+public:
+    static constexpr auto kIndexed = _Table::kRows <= 16;
+
+    /* The number of functions of _Inputs inputs, if it fits the bit index. */
+    static constexpr auto kFunctions = kIndexed ? std::size_t{1} << _Table::kRows
+                                                : std::numeric_limits<std::size_t>::max();
+
+    // whether the table is new, marking it as seen
+    auto insert(const _Table &table) -> bool {
+        if constexpr (kIndexed) {
+            const auto index = static_cast<std::size_t>(table.words()[0]);
+            if (_M_seen.contains(index))
+                return false;
+            _M_seen.insert(index);
+            return true;
+        } else {
+            return _M_seen.insert(table).second;
+        }
+    }
+
+private:
+    using _Set = std::conditional_t<
+        kIndexed, set_operation::dense_bitset<kFunctions>,
+        std::unordered_set<_Table, hash>>;
+
+    _Set _M_seen;
+};
+
+/* The tuples with found[i] at p, found[0, before) before it, found[0, after) after. */
+struct new_tuples {
+    std::size_t i;
+    std::size_t p;
+    std::size_t before;
+    std::size_t after;
+};
+
+/**
+ * Call fn(gate(args)) for each tuple in the range, until fn returns false.
+ * Taking i as the first new table at p, so that before is where the new
+ * tables start, each tuple with a new table comes once.
+ *
+ * rows holds the gate with args[0, _Pos) fixed, as a table for each setting of
+ * the rest. Fixing args[_Pos] muxes the pairs of rows, as in gather, so the
+ * innermost loop costs one mux per tuple.
+ */
+template <
+    std::size_t _Pos, std::size_t _Arity, typename _Table, std::size_t _Nm, typename _Fn>
+inline auto for_each_new_tuple(
+    const std::vector<_Table> &found, const new_tuples &range,
+    const std::array<_Table, _Nm> &rows, _Fn &fn
+) -> bool {
+    if constexpr (_Pos == _Arity) {
+        return fn(rows[0]);
+    } else {
+        const auto first = _Pos == range.p ? range.i : 0;
+        const auto last  = _Pos < range.p    ? range.before
+                           : _Pos == range.p ? range.i + 1
+                                             : range.after;
+        for (auto j = first; j < last; ++j) {
+            // found may grow in fn, so found[j] is read before it
+            const auto &x = found[j];
+            auto next     = std::array<_Table, _Nm / 2>{};
+            for (std::size_t r = 0; r < _Nm / 2; ++r)
+                next[r] = rows[2 * r] ^ ((rows[2 * r] ^ rows[2 * r + 1]) & x);
+            if (!for_each_new_tuple<_Pos + 1, _Arity>(found, range, next, fn))
+                return false;
+        }
+        return true;
+    }
+}
+
+/* A gate as the constant table of each of its rows, for for_each_new_tuple. */
+template <std::size_t _Inputs, std::size_t _Arity>
+using gate_row = std::array<sliced_table<_Inputs>, std::size_t{1} << _Arity>;
+
+template <std::size_t _Inputs, std::size_t _Arity>
+inline auto gate_rows(const bool_table_vec<_Arity> &gates)
+    -> std::vector<gate_row<_Inputs, _Arity>> {
+    auto rows = std::vector<gate_row<_Inputs, _Arity>>{};
+    for (const auto &gate : gates) {
+        auto &row = rows.emplace_back();
+        for (std::size_t r = 0; r < row.size(); ++r)
+            row[r] = sliced_table<_Inputs>::constant(gate[r]);
+    }
+    return rows;
+}
+
+// Post's five maximal clones, as the bits of a mask
+inline constexpr auto kPreservesZero = 1u;
+inline constexpr auto kPreservesOne  = 2u;
+inline constexpr auto kMonotone      = 4u;
+inline constexpr auto kSelfDual      = 8u;
+inline constexpr auto kAffine        = 16u;
+inline constexpr auto kAllClones     = 31u;
+
+/* The maximal clones which contain the gate. */
+template <std::size_t _Arity>
+constexpr auto post_clones(const bool_table<_Arity> &gate) -> unsigned {
+    constexpr auto kLast = (std::size_t{1} << _Arity) - 1;
+
+    auto clones = kAllClones;
+    if (gate[0])
+        clones &= ~kPreservesZero;
+    if (!gate[kLast])
+        clones &= ~kPreservesOne;
+
+    // the only affine candidate: the constant, xor the inputs which flip it alone
+    const bool constant = gate[0];
+    auto linear         = std::size_t{};
+    for (std::size_t i = 0; i < _Arity; ++i)
+        if (gate[std::size_t{1} << i] != constant)
+            linear |= std::size_t{1} << i;
+
+    for (std::size_t r = 0; r <= kLast; ++r) {
+        if (gate[r] == gate[r ^ kLast])
+            clones &= ~kSelfDual;
+        if (gate[r] != (constant != (std::popcount(r & linear) % 2 == 1)))
+            clones &= ~kAffine;
+        for (std::size_t i = 0; i < _Arity; ++i)
+            if (gate[r] && !gate[r | std::size_t{1} << i])
+                clones &= ~kMonotone;
+    }
+    return clones;
+}
+
+/**
+ * The number of functions of _Inputs inputs in every clone of the mask, all of
+ * them for none, by the known sizes of their intersections. Past std::size_t
+ * it saturates.
+ */
+template <std::size_t _Inputs>
+constexpr auto clone_size(unsigned clones) -> std::size_t {
+    constexpr auto kMax  = std::numeric_limits<std::size_t>::max();
+    constexpr auto kRows = std::size_t{1} << _Inputs;
+    // monotone functions, Dedekind's numbers, and the self-dual ones among them
+    constexpr auto kMonotoneSizes = std::array<std::size_t, 8>{
+        2, 3, 6, 20, 168, 7'581, 7'828'354, 2'414'682'040'998,
+    };
+    constexpr auto kSelfDualSizes = std::array<std::size_t, 9>{
+        0, 1, 2, 4, 12, 81, 2'646, 1'422'564, 229'809'982'112,
+    };
+    const auto pow2 = [](std::size_t e) {
+        return e < std::numeric_limits<std::size_t>::digits ? std::size_t{1} << e : kMax;
+    };
+    const auto lookup = [](const auto &sizes) {
+        return _Inputs < sizes.size() ? sizes[_Inputs] : kMax;
+    };
+
+    // each of preserving 0 and 1 drops a constant, or halves the rest
+    const auto fixed = std::size_t{(clones & kPreservesZero) != 0} +
+                       std::size_t{(clones & kPreservesOne) != 0};
+    const auto dual  = (clones & kSelfDual) != 0;
+
+    if (clones & kAffine) {
+        if (clones & kMonotone) // the constants and the inputs
+            return dual ? _Inputs : _Inputs + 2 - fixed;
+        if (dual) // an odd number of inputs
+            return fixed != 0 ? pow2(_Inputs - 1) : pow2(_Inputs);
+        return pow2(_Inputs + 1 - fixed);
+    }
+    if (clones & kMonotone) {
+        if (dual)
+            return lookup(kSelfDualSizes);
+        const auto size = lookup(kMonotoneSizes);
+        return size == kMax ? kMax : size - fixed;
+    }
+    if (dual) // a self-dual function preserves 0 exactly when it preserves 1
+        return pow2(kRows / 2 - (fixed != 0 ? 1 : 0));
+    return pow2(kRows - fixed);
+}
+
+/* The maximal clones which contain every gate, none when they are complete. */
+template <std::size_t _Arity>
+inline auto post_clones(const bool_table_vec<_Arity> &gates) -> unsigned {
+    auto clones = kAllClones;
+    for (const auto &gate : gates)
+        clones &= post_clones(gate);
+    return clones;
+}
+
+/* The rest of a complete closure up to limit, in the order of their tables. */
+template <std::size_t _Inputs, typename _Insert>
+inline auto append_rest(
+    std::vector<sliced_table<_Inputs>> &found, std::size_t limit, _Insert &&insert
+) -> void {
+    using _Table = sliced_table<_Inputs>;
+    for (auto index = std::size_t{}; found.size() < limit; ++index) {
+        const auto table = _Table{std::bitset<_Table::kRows>{index}};
+        if (insert(table))
+            found.push_back(table);
+    }
+}
+
+} // namespace __detail
+
+/**
+ * The closure of the gates over _Inputs inputs: every function which a circuit
+ * of the gates computes from the inputs, in the order found. A gate of
+ * _Arity inputs takes any tables found so far as its inputs.
+ *
+ * Each table is combined only with the tables found before it, once, so no
+ * tuple is tried twice, but the cost still grows as the closure to the power
+ * _Arity. The search stops after limit tables, or once the closure fills
+ * the smallest of Post's maximal clones which contain every gate. When no
+ * such clone contains them all, the gates are complete, and the functions
+ * after the inputs come by their tables, with no search. find_possible_table
+ * is the 2-input case.
+ */
+template <std::size_t _Inputs, std::size_t _Arity>
+    requires(_Arity <= _Inputs)
+inline auto find_closure(
+    const bool_table_vec<_Arity> &gates,
+    std::size_t limit = std::numeric_limits<std::size_t>::max()
+) -> std::vector<sliced_table<_Inputs>> {
+    using _Table = sliced_table<_Inputs>;
+    using _Seen  = __detail::seen_tables<_Inputs>;
+
+    const auto clones = __detail::post_clones(gates);
+    limit             = std::min(limit, __detail::clone_size<_Inputs>(clones));
+
+    auto seen      = _Seen{};
+    auto found     = std::vector<_Table>{};
+    const auto add = [&](const _Table &table) {
+        if (seen.insert(table))
+            found.push_back(table);
+        return found.size() < limit;
+    };
+
+    for (std::size_t i = 0; i < _Inputs; ++i)
+        if (!add(_Table::projection(i)))
+            return found;
+
+    if (clones == 0) {
+        __detail::append_rest(found, limit, [&seen](const _Table &table) {
+            return seen.insert(table);
+        });
+        return found;
+    }
+
+    const auto rows = __detail::gate_rows<_Inputs>(gates);
+    [&] {
+        using __detail::for_each_new_tuple;
+        for (std::size_t i = 0; i < found.size(); ++i)
+            for (std::size_t p = 0; p < _Arity; ++p)
+                for (const auto &row : rows)
+                    if (!for_each_new_tuple<0, _Arity>(found, {i, p, i, i + 1}, row, add))
+                        return;
+    }();
+    return found;
+}
+
 } // namespace boolean
@@ -0,0 +1,179 @@
+#pragma once
+#include "bools.h"
+#include "par.h"
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <vector>
+
+namespace boolean {
+
+namespace __detail {
+
+using set_operation::__detail::default_threads;
+using set_operation::__detail::parallel_tasks;
+
+/* The tables found so far, one atomic bit per function, for any thread to mark. */
+template <std::size_t _Inputs>
+struct atomic_seen_tables {
+private:
+    using _Table = sliced_table<_Inputs>;
+
+    static_assert(seen_tables<_Inputs>::kIndexed, "Too many inputs");
+    static constexpr auto kWords = (seen_tables<_Inputs>::kFunctions + 63) / 64;
+
+public:
+    atomic_seen_tables() : _M_words(kWords) {}
+
+    // whether the table is new, marking it as seen
+    auto insert(const _Table &table) -> bool {
+        const auto index = static_cast<std::size_t>(table.words()[0]);
+        const auto bit   = word_t{1} << (index % 64);
+        auto &word       = _M_words[index / 64];
+        // most tables come up again and again, so look before taking the line
+        if (word.load(std::memory_order_relaxed) & bit)
+            return false;
+        return (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+    }
+
+private:
+    std::vector<std::atomic<word_t>> _M_words;
+};
+
+} // namespace __detail
+
+/**
+ * find_closure on up to threads threads, or one per core when threads is 0.
+ * The search goes in rounds: the tuples with a table of the last round are
+ * shared out one (table, position, gate) at a time, each worker queues what
+ * it finds, and the queues, sorted, make the next round. A bit per function
+ * marks the tables found, so this takes up to 4 inputs.
+ *
+ * The tables come in another order than from find_closure, except for complete
+ * gates, which need no search. Which tables make a limit depends on timing.
+ */
+template <std::size_t _Inputs, std::size_t _Arity>
+    requires(_Arity <= _Inputs)
+inline auto parallel_closure(
+    const bool_table_vec<_Arity> &gates, std::size_t threads = 0,
+    std::size_t limit = std::numeric_limits<std::size_t>::max()
+) -> std::vector<sliced_table<_Inputs>> {
+    using _Table = sliced_table<_Inputs>;
+
+    if (threads == 0)
+        threads = __detail::default_threads();
+    const auto clones = __detail::post_clones(gates);
+    limit             = std::min(limit, __detail::clone_size<_Inputs>(clones));
+
+    auto seen  = __detail::atomic_seen_tables<_Inputs>{};
+    auto found = std::vector<_Table>{};
+    for (std::size_t i = 0; i < _Inputs && found.size() < limit; ++i)
+        if (seen.insert(_Table::projection(i)))
+            found.push_back(_Table::projection(i));
+
+    const auto insert = [&seen](const _Table &table) { return seen.insert(table); };
+    if (clones == 0) {
+        __detail::append_rest(found, limit, insert);
+        return found;
+    }
+
+    const auto rows = __detail::gate_rows<_Inputs>(gates);
+    auto queues     = std::vector<std::vector<_Table>>(threads);
+    auto errors     = std::vector<std::exception_ptr>(threads + 1); // the last for merge
+    auto count      = std::atomic<std::size_t>{found.size()};
+    auto next       = std::atomic<std::size_t>{};
+    auto stop       = std::atomic<bool>{found.size() >= limit};
+
+    // the round takes the tables in found[begin, end)
+    auto begin = std::size_t{};
+    auto end   = found.size();
+    auto done  = stop.load() || rows.empty();
+
+    // between rounds, on one thread while the others wait
+    const auto merge = [&]() noexcept {
+        try {
+            begin = end;
+            for (auto &queue : queues) {
+                found.insert(found.end(), queue.begin(), queue.end());
+                queue.clear();
+            }
+            const auto first = found.begin() + static_cast<std::ptrdiff_t>(begin);
+            std::ranges::sort(first, found.end());
+            end = found.size();
+            next.store(0, std::memory_order_relaxed);
+        } catch (...) {
+            errors.back() = std::current_exception();
+            stop.store(true, std::memory_order_relaxed);
+        }
+        done = begin == end || stop.load(std::memory_order_relaxed);
+    };
+    auto sync = std::barrier(static_cast<std::ptrdiff_t>(threads), merge);
+
+    __detail::parallel_tasks(threads, [&](std::size_t k) {
+        const auto add = [&](const _Table &table) {
+            if (seen.insert(table)) {
+                queues[k].push_back(table);
+                const auto total = count.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (total >= limit)
+                    stop.store(true, std::memory_order_relaxed);
+            }
+            return !stop.load(std::memory_order_relaxed);
+        };
+
+        while (!done) {
+            try {
+                const auto tasks = (end - begin) * _Arity * rows.size();
+                auto task        = std::size_t{};
+                while ((task = next.fetch_add(1, std::memory_order_relaxed)) < tasks) {
+                    const auto &row  = rows[task % rows.size()];
+                    const auto p     = task / rows.size() % _Arity;
+                    const auto i     = begin + task / rows.size() / _Arity;
+                    const auto range = __detail::new_tuples{i, p, begin, end};
+                    if (!__detail::for_each_new_tuple<0, _Arity>(found, range, row, add))
+                        break;
+                }
+            } catch (...) {
+                errors[k] = std::current_exception();
+                stop.store(true, std::memory_order_relaxed);
+            }
+            sync.arrive_and_wait();
+        }
+    });
+
+    for (auto &error : errors)
+        if (error != nullptr)
+            std::rethrow_exception(error);
+
+    if (found.size() > limit)
+        found.resize(limit);
+    return found;
+}
+
+/**
+ * find_closure of each library, the libraries shared out one at a time to up
+ * to threads threads, or one per core when threads is 0.
+ */
+template <std::size_t _Inputs, std::size_t _Arity>
+inline auto parallel_closures(
+    const std::vector<bool_table_vec<_Arity>> &libraries, std::size_t threads = 0
+) -> std::vector<std::vector<sliced_table<_Inputs>>> {
+    using _Closure = std::vector<sliced_table<_Inputs>>;
+
+    if (threads == 0)
+        threads = __detail::default_threads();
+
+    const auto workers = std::clamp<std::size_t>(libraries.size(), 1, threads);
+    auto result        = std::vector<_Closure>(libraries.size());
+    auto next          = std::atomic<std::size_t>{};
+    __detail::parallel_tasks(workers, [&](std::size_t) {
+        auto k = std::size_t{};
+        while ((k = next.fetch_add(1, std::memory_order_relaxed)) < libraries.size())
+            result[k] = find_closure<_Inputs>(libraries[k]);
+    });
+    return result;
+}
+
+} // namespace boolean
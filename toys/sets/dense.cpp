@@ -0,0 +1,60 @@
+#include "../bench/timing.h"
+#include "dense.h"
+#include <cstddef>
+#include <ios>
+#include <iostream>
+#include <ratio>
+
+template <typename _Set>
+auto display_set(const _Set &set) -> void {
+    std::cout << "{ ";
+    for (const auto elem : set)
+        std::cout << elem << ' ';
+    std::cout << "}" << std::endl;
+}
+
+auto main() -> int {
+    auto a = dense_bitset<200>{};
+    auto b = dense_bitset<200>{};
+    for (auto i : {1, 3, 64, 130, 199})
+        a.insert(i);
+    for (auto i : {3, 64, 150})
+        b.insert(i);
+
+    display_set(a & b);
+    display_set(a | b);
+    display_set(a ^ b);
+    display_set(a / b); // derived in one fused pass over the words
+    std::cout << (~a).count() << ' ' << full_set<dense_bitset<200>>().count() << '\n';
+
+    std::cout << std::boolalpha;
+    std::cout << ((a & b) < a) << ' ' << (a <= b) << ' ';
+    std::cout << (a / b + (a & b) == a) << '\n';
+
+    // universes of different sizes mix, and missing bits count as absent
+    auto x = dynamic_bitset{100};
+    auto y = dynamic_bitset{1000};
+    x.insert(7);
+    y.insert(7);
+    y.insert(999);
+    display_set(x & y);
+    display_set(x ^ y);
+    std::cout << (x <= y) << ' ' << (y - x).universe() << '\n';
+
+    // large universes, where the operations should be bound by memory
+    constexpr auto kBits = std::size_t{1} << 28;
+    auto big0            = dynamic_bitset{kBits};
+    auto big1            = dynamic_bitset{kBits};
+    for (std::size_t i = 0; i < kBits; i += 3)
+        big0.insert(i);
+    for (std::size_t i = 0; i < kBits; i += 5)
+        big1.insert(i);
+    constexpr auto kBytes = kBits / 8;
+    const auto and_ms = measure<32, std::milli>("and  ", [&] {
+        return (big0 & big1).universe();
+    });
+    std::cout << "  " << 3 * kBytes / and_ms / 1e6 << " GB/s\n";
+    const auto count_ms = measure<32, std::milli>("count", [&] { return big0.count(); });
+    std::cout << "  " << kBytes / count_ms / 1e6 << " GB/s\n";
+    std::cout << "both: " << (big0 & big1).count() << '\n';
+}
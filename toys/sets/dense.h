@@ -0,0 +1,541 @@
+#pragma once
+#include "sets.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+inline namespace set_operation {
+
+namespace __detail {
+
+using word_t = std::uint64_t;
+
+inline constexpr auto kWordBits = std::size_t{64};
+
+inline constexpr auto words_for(std::size_t bits) -> std::size_t {
+    return (bits + kWordBits - 1) / kWordBits;
+}
+
+// the valid bits of the last word, so that bits beyond the universe stay 0
+inline constexpr auto tail_mask(std::size_t bits) -> word_t {
+    return bits % kWordBits == 0 ? ~word_t{} : (word_t{1} << bits % kWordBits) - 1;
+}
+
+enum class bit_op { bit_and, bit_or, bit_xor, bit_andnot, bit_not };
+
+template <bit_op _Op>
+inline constexpr auto apply_word(word_t a, word_t b) -> word_t {
+    if constexpr (_Op == bit_op::bit_and)
+        return a & b;
+    else if constexpr (_Op == bit_op::bit_or)
+        return a | b;
+    else if constexpr (_Op == bit_op::bit_xor)
+        return a ^ b;
+    else if constexpr (_Op == bit_op::bit_andnot)
+        return a & ~b;
+    else
+        return ~a;
+}
+
+#if defined(__AVX512F__)
+template <bit_op _Op>
+inline auto apply_vector(__m512i a, __m512i b) -> __m512i {
+    if constexpr (_Op == bit_op::bit_and)
+        return _mm512_and_si512(a, b);
+    else if constexpr (_Op == bit_op::bit_or)
+        return _mm512_or_si512(a, b);
+    else if constexpr (_Op == bit_op::bit_xor)
+        return _mm512_xor_si512(a, b);
+    else if constexpr (_Op == bit_op::bit_andnot)
+        return _mm512_ternarylogic_epi64(a, b, b, 0x30); // andnot trips GCC 12
+    else
+        return _mm512_ternarylogic_epi64(a, a, a, 0x55);
+}
+#elif defined(__AVX2__)
+template <bit_op _Op>
+inline auto apply_vector(__m256i a, __m256i b) -> __m256i {
+    if constexpr (_Op == bit_op::bit_and)
+        return _mm256_and_si256(a, b);
+    else if constexpr (_Op == bit_op::bit_or)
+        return _mm256_or_si256(a, b);
+    else if constexpr (_Op == bit_op::bit_xor)
+        return _mm256_xor_si256(a, b);
+    else if constexpr (_Op == bit_op::bit_andnot)
+        return _mm256_andnot_si256(b, a);
+    else
+        return _mm256_xor_si256(a, _mm256_set1_epi64x(-1));
+}
+#endif
+
+/* dst[i] = a[i] op b[i] for n words, where dst may alias a or b (unused for bit_not). */
+template <bit_op _Op>
+inline auto bit_apply(word_t *dst, const word_t *a, const word_t *b, std::size_t n)
+    -> void {
+    auto i = std::size_t{};
+#if defined(__AVX512F__)
+    for (const auto stop = n / 8 * 8; i != stop; i += 8) {
+        const auto x = _mm512_loadu_si512(a + i);
+        const auto y = _Op == bit_op::bit_not ? x : _mm512_loadu_si512(b + i);
+        _mm512_storeu_si512(dst + i, apply_vector<_Op>(x, y));
+    }
+#elif defined(__AVX2__)
+    for (const auto stop = n / 4 * 4; i != stop; i += 4) {
+        const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const auto y = _Op == bit_op::bit_not
+                           ? x
+                           : _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        const auto z = apply_vector<_Op>(x, y);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), z);
+    }
+#endif
+    for (; i < n; ++i)
+        dst[i] = apply_word<_Op>(a[i], _Op == bit_op::bit_not ? 0 : b[i]);
+}
+
+inline auto bit_count(const word_t *a, std::size_t n) -> std::size_t {
+    auto i     = std::size_t{};
+    auto total = std::size_t{};
+#if defined(__AVX512VPOPCNTDQ__)
+    auto sum = _mm512_setzero_si512();
+    for (const auto stop = n / 8 * 8; i != stop; i += 8)
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_loadu_si512(a + i)));
+    alignas(64) std::uint64_t lanes[8];
+    _mm512_store_si512(lanes, sum);
+    for (const auto lane : lanes)
+        total += static_cast<std::size_t>(lane);
+#endif
+    // independent partial sums, so that the popcnt instructions overlap
+    auto sums = std::array<std::size_t, 4>{};
+    for (const auto stop = n / 4 * 4; i < stop; i += 4)
+        for (std::size_t j = 0; j < 4; ++j)
+            sums[j] += static_cast<std::size_t>(std::popcount(a[i + j]));
+    for (; i < n; ++i)
+        total += static_cast<std::size_t>(std::popcount(a[i]));
+    return total + sums[0] + sums[1] + sums[2] + sums[3];
+}
+
+inline auto bit_none(const word_t *a, std::size_t n) -> bool {
+    auto any = word_t{};
+    for (std::size_t i = 0; i < n; ++i)
+        any |= a[i];
+    return any == 0;
+}
+
+/* Call fn(index) for each set bit, in increasing order. */
+template <typename _Fn>
+inline auto bit_for_each(const word_t *a, std::size_t n, _Fn &&fn) -> void {
+    for (std::size_t i = 0; i < n; ++i)
+        for (auto word = a[i]; word != 0; word &= word - 1)
+            fn(i * kWordBits + static_cast<std::size_t>(std::countr_zero(word)));
+}
+
+/* Forward iterator over the indices of the set bits. */
+struct bit_iterator {
+public:
+    using value_type      = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    bit_iterator() = default;
+    bit_iterator(const word_t *words, std::size_t n) : _M_words(words), _M_size(n) {
+        _M_current = n != 0 ? words[0] : 0;
+        this->_M_skip();
+    }
+
+    auto operator*() const -> std::size_t {
+        const auto bit = static_cast<std::size_t>(std::countr_zero(_M_current));
+        return _M_index * kWordBits + bit;
+    }
+
+    auto operator++() -> bit_iterator & {
+        _M_current &= _M_current - 1;
+        this->_M_skip();
+        return *this;
+    }
+
+    auto operator++(int) -> bit_iterator {
+        auto copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    auto operator==(const bit_iterator &) const -> bool = default;
+
+    auto operator==(std::default_sentinel_t) const -> bool {
+        return _M_index == _M_size;
+    }
+
+private:
+    // move to the next non-zero word, if the current one is used up
+    auto _M_skip() -> void {
+        while (_M_current == 0 && _M_index != _M_size)
+            _M_current = ++_M_index != _M_size ? _M_words[_M_index] : 0;
+    }
+
+    const word_t *_M_words{};
+    std::size_t _M_size{};
+    std::size_t _M_index{};
+    word_t _M_current{};
+};
+
+} // namespace __detail
+
+/**
+ * A set of integers in [0, _Nm), one bit each.
+ * &, |, ^, ~, the compound assignments and count() run over whole words
+ * with AVX-512 or AVX2 when the target supports them. Other operations come
+ * from set_op_traits.
+ */
+template <std::size_t _Nm>
+struct dense_bitset {
+private:
+    using word_t = __detail::word_t;
+    using bit_op = __detail::bit_op;
+
+    static constexpr auto kWords = __detail::words_for(_Nm);
+
+    struct uninit_t {};
+
+    dense_bitset(uninit_t) {}
+
+    template <bit_op _Op>
+    static auto _S_apply(const dense_bitset &a, const dense_bitset &b) -> dense_bitset {
+        auto result = dense_bitset{uninit_t{}};
+        __detail::bit_apply<_Op>(result.data(), a.data(), b.data(), kWords);
+        return result;
+    }
+
+    template <bit_op _Op>
+    auto _M_assign(const dense_bitset &rhs) -> dense_bitset & {
+        __detail::bit_apply<_Op>(this->data(), this->data(), rhs.data(), kWords);
+        return *this;
+    }
+
+public:
+    dense_bitset() : _M_words{} {}
+
+    static constexpr auto universe() -> std::size_t {
+        return _Nm;
+    }
+
+    /* All of these require i < universe(). */
+
+    auto contains(std::size_t i) const -> bool {
+        return (_M_words[i / __detail::kWordBits] >> (i % __detail::kWordBits)) & 1;
+    }
+
+    auto insert(std::size_t i) -> void {
+        _M_words[i / __detail::kWordBits] |= word_t{1} << (i % __detail::kWordBits);
+    }
+
+    auto erase(std::size_t i) -> void {
+        _M_words[i / __detail::kWordBits] &= ~(word_t{1} << (i % __detail::kWordBits));
+    }
+
+    auto count() const -> std::size_t {
+        return __detail::bit_count(this->data(), kWords);
+    }
+
+    auto empty() const -> bool {
+        return __detail::bit_none(this->data(), kWords);
+    }
+
+    auto begin() const -> __detail::bit_iterator {
+        return {this->data(), kWords};
+    }
+
+    auto end() const -> std::default_sentinel_t {
+        return {};
+    }
+
+    template <typename _Fn>
+    auto for_each(_Fn &&fn) const -> void {
+        __detail::bit_for_each(this->data(), kWords, fn);
+    }
+
+    auto data() const -> const word_t * {
+        return _M_words.data();
+    }
+
+    auto data() -> word_t * {
+        return _M_words.data();
+    }
+
+    auto operator&=(const dense_bitset &rhs) -> dense_bitset & {
+        return this->_M_assign<bit_op::bit_and>(rhs);
+    }
+
+    auto operator|=(const dense_bitset &rhs) -> dense_bitset & {
+        return this->_M_assign<bit_op::bit_or>(rhs);
+    }
+
+    auto operator^=(const dense_bitset &rhs) -> dense_bitset & {
+        return this->_M_assign<bit_op::bit_xor>(rhs);
+    }
+
+    auto operator/=(const dense_bitset &rhs) -> dense_bitset & {
+        return this->_M_assign<bit_op::bit_andnot>(rhs);
+    }
+
+    friend auto operator&(const dense_bitset &a, const dense_bitset &b) -> dense_bitset {
+        return _S_apply<bit_op::bit_and>(a, b);
+    }
+
+    friend auto operator|(const dense_bitset &a, const dense_bitset &b) -> dense_bitset {
+        return _S_apply<bit_op::bit_or>(a, b);
+    }
+
+    friend auto operator^(const dense_bitset &a, const dense_bitset &b) -> dense_bitset {
+        return _S_apply<bit_op::bit_xor>(a, b);
+    }
+
+    friend auto operator~(const dense_bitset &a) -> dense_bitset {
+        auto result = _S_apply<bit_op::bit_not>(a, a);
+        if constexpr (kWords != 0)
+            result._M_words.back() &= __detail::tail_mask(_Nm);
+        return result;
+    }
+
+    friend auto operator==(const dense_bitset &a, const dense_bitset &b) -> bool {
+        return std::memcmp(a.data(), b.data(), sizeof(word_t) * kWords) == 0;
+    }
+
+private:
+    alignas(64) std::array<word_t, kWords> _M_words;
+};
+
+/**
+ * A set of integers in [0, universe()), with the universe chosen at runtime.
+ * Sets of different universes may be mixed: bits missing from the smaller
+ * one count as absent, and the result takes the larger universe.
+ * Operators on an rvalue, and compound assignments, reuse its storage.
+ */
+struct dynamic_bitset {
+private:
+    using word_t = __detail::word_t;
+    using bit_op = __detail::bit_op;
+
+    struct uninit_t {};
+
+    dynamic_bitset(std::size_t bits, uninit_t) :
+        _M_bits(bits), _M_words(std::make_unique_for_overwrite<word_t[]>(
+                           __detail::words_for(bits)
+                       )) {}
+
+    auto _M_size() const -> std::size_t {
+        return __detail::words_for(_M_bits);
+    }
+
+    // bits past the shorter operand: 0 for &, and for a / b past a, else the longer ones
+    template <bit_op _Op>
+    static auto _S_tail(
+        word_t *dst, const dynamic_bitset &a, const dynamic_bitset &b, std::size_t from
+    ) -> void {
+        const auto &longer = a._M_size() >= b._M_size() ? a : b;
+        const auto n       = longer._M_size() - from;
+        if (_Op == bit_op::bit_and || (_Op == bit_op::bit_andnot && &longer != &a))
+            std::fill_n(dst + from, n, word_t{});
+        else if (dst != longer.data())
+            std::copy_n(longer.data() + from, n, dst + from);
+    }
+
+    template <bit_op _Op>
+    static auto _S_apply(const dynamic_bitset &a, const dynamic_bitset &b)
+        -> dynamic_bitset {
+        const auto common = std::min(a._M_size(), b._M_size());
+        auto result       = dynamic_bitset{std::max(a._M_bits, b._M_bits), uninit_t{}};
+        __detail::bit_apply<_Op>(result.data(), a.data(), b.data(), common);
+        _S_tail<_Op>(result.data(), a, b, common);
+        return result;
+    }
+
+    template <bit_op _Op>
+    static auto _S_apply(dynamic_bitset &&a, const dynamic_bitset &b) -> dynamic_bitset {
+        if (a._M_size() < b._M_size())
+            return _S_apply<_Op>(a, b);
+        const auto common = b._M_size();
+        __detail::bit_apply<_Op>(a.data(), a.data(), b.data(), common);
+        _S_tail<_Op>(a.data(), a, b, common);
+        a._M_bits = std::max(a._M_bits, b._M_bits);
+        return std::move(a);
+    }
+
+    // in place, unless rhs has the larger universe
+    template <bit_op _Op>
+    auto _M_assign(const dynamic_bitset &rhs) -> dynamic_bitset & {
+        *this = _S_apply<_Op>(std::move(*this), rhs);
+        return *this;
+    }
+
+    static auto _S_not(dynamic_bitset &&a) -> dynamic_bitset {
+        __detail::bit_apply<bit_op::bit_not>(a.data(), a.data(), a.data(), a._M_size());
+        if (a._M_size() != 0)
+            a.data()[a._M_size() - 1] &= __detail::tail_mask(a._M_bits);
+        return std::move(a);
+    }
+
+public:
+    dynamic_bitset() = default;
+
+    explicit dynamic_bitset(std::size_t bits) :
+        _M_bits(bits), _M_words(std::make_unique<word_t[]>(__detail::words_for(bits))) {}
+
+    dynamic_bitset(const dynamic_bitset &rhs) : dynamic_bitset(rhs._M_bits, uninit_t{}) {
+        std::copy_n(rhs.data(), rhs._M_size(), this->data());
+    }
+
+    dynamic_bitset(dynamic_bitset &&rhs) noexcept :
+        _M_bits(std::exchange(rhs._M_bits, 0)), _M_words(std::move(rhs._M_words)) {}
+
+    auto operator=(const dynamic_bitset &rhs) -> dynamic_bitset & {
+        if (this != &rhs)
+            *this = dynamic_bitset{rhs};
+        return *this;
+    }
+
+    auto operator=(dynamic_bitset &&rhs) noexcept -> dynamic_bitset & {
+        _M_bits  = std::exchange(rhs._M_bits, 0);
+        _M_words = std::move(rhs._M_words);
+        return *this;
+    }
+
+    ~dynamic_bitset() = default;
+
+    auto universe() const -> std::size_t {
+        return _M_bits;
+    }
+
+    /* All of these require i < universe(). */
+
+    auto contains(std::size_t i) const -> bool {
+        return (_M_words[i / __detail::kWordBits] >> (i % __detail::kWordBits)) & 1;
+    }
+
+    auto insert(std::size_t i) -> void {
+        _M_words[i / __detail::kWordBits] |= word_t{1} << (i % __detail::kWordBits);
+    }
+
+    auto erase(std::size_t i) -> void {
+        _M_words[i / __detail::kWordBits] &= ~(word_t{1} << (i % __detail::kWordBits));
+    }
+
+    auto count() const -> std::size_t {
+        return __detail::bit_count(this->data(), this->_M_size());
+    }
+
+    auto empty() const -> bool {
+        return __detail::bit_none(this->data(), this->_M_size());
+    }
+
+    auto begin() const -> __detail::bit_iterator {
+        return {this->data(), this->_M_size()};
+    }
+
+    auto end() const -> std::default_sentinel_t {
+        return {};
+    }
+
+    template <typename _Fn>
+    auto for_each(_Fn &&fn) const -> void {
+        __detail::bit_for_each(this->data(), this->_M_size(), fn);
+    }
+
+    auto data() const -> const word_t * {
+        return _M_words.get();
+    }
+
+    auto data() -> word_t * {
+        return _M_words.get();
+    }
+
+    auto operator&=(const dynamic_bitset &rhs) -> dynamic_bitset & {
+        return this->_M_assign<bit_op::bit_and>(rhs);
+    }
+
+    auto operator|=(const dynamic_bitset &rhs) -> dynamic_bitset & {
+        return this->_M_assign<bit_op::bit_or>(rhs);
+    }
+
+    auto operator^=(const dynamic_bitset &rhs) -> dynamic_bitset & {
+        return this->_M_assign<bit_op::bit_xor>(rhs);
+    }
+
+    auto operator/=(const dynamic_bitset &rhs) -> dynamic_bitset & {
+        return this->_M_assign<bit_op::bit_andnot>(rhs);
+    }
+
+    friend auto operator&(const dynamic_bitset &a, const dynamic_bitset &b)
+        -> dynamic_bitset {
+        return _S_apply<bit_op::bit_and>(a, b);
+    }
+
+    friend auto operator&(dynamic_bitset &&a, const dynamic_bitset &b) -> dynamic_bitset {
+        return _S_apply<bit_op::bit_and>(std::move(a), b);
+    }
+
+    friend auto operator|(const dynamic_bitset &a, const dynamic_bitset &b)
+        -> dynamic_bitset {
+        return _S_apply<bit_op::bit_or>(a, b);
+    }
+
+    friend auto operator|(dynamic_bitset &&a, const dynamic_bitset &b) -> dynamic_bitset {
+        return _S_apply<bit_op::bit_or>(std::move(a), b);
+    }
+
+    friend auto operator^(const dynamic_bitset &a, const dynamic_bitset &b)
+        -> dynamic_bitset {
+        return _S_apply<bit_op::bit_xor>(a, b);
+    }
+
+    friend auto operator^(dynamic_bitset &&a, const dynamic_bitset &b) -> dynamic_bitset {
+        return _S_apply<bit_op::bit_xor>(std::move(a), b);
+    }
+
+    friend auto operator~(const dynamic_bitset &a) -> dynamic_bitset {
+        return _S_not(dynamic_bitset{a});
+    }
+
+    friend auto operator~(dynamic_bitset &&a) -> dynamic_bitset {
+        return _S_not(std::move(a));
+    }
+
+    friend auto operator==(const dynamic_bitset &a, const dynamic_bitset &b) -> bool {
+        const auto &longer = a._M_size() >= b._M_size() ? a : b;
+        const auto common  = std::min(a._M_size(), b._M_size());
+        return std::equal(a.data(), a.data() + common, b.data()) &&
+               __detail::bit_none(longer.data() + common, longer._M_size() - common);
+    }
+
+private:
+    std::size_t _M_bits{};
+    std::unique_ptr<word_t[]> _M_words;
+};
+
+template <std::size_t _Nm>
+struct set_op_traits<dense_bitset<_Nm>> : std::true_type {
+    static constexpr auto costs    = set_costs::uniform(set_cost::universe);
+    static constexpr auto in_place = set_in_place{true, true, true, true};
+};
+
+template <std::size_t _Nm>
+struct word_set_traits<dense_bitset<_Nm>> : std::true_type {
+    static constexpr auto words = __detail::words_for(_Nm);
+};
+
+template <>
+struct set_op_traits<dynamic_bitset> : std::true_type {
+    static constexpr auto costs    = set_costs::uniform(set_cost::universe);
+    static constexpr auto in_place = set_in_place{true, true, true, true};
+};
+
+} // namespace set_operation
@@ -0,0 +1,74 @@
+#include "../bench/timing.h"
+#include "flat.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+template <typename _Set>
+auto display_set(const _Set &set) -> void {
+    std::cout << "{ ";
+    for (const auto &elem : set)
+        std::cout << elem << ' ';
+    std::cout << "}" << std::endl;
+}
+
+auto random_set(std::size_t n, std::uint32_t range, std::mt19937 &gen) -> flat_set<int> {
+    auto dist   = std::uniform_int_distribution<int>(0, static_cast<int>(range));
+    auto values = std::vector<int>(n);
+    for (auto &value : values)
+        value = dist(gen);
+    return flat_set<int>{std::move(values)};
+}
+
+auto main() -> int {
+    const auto a = flat_set<int>{5, 1, 3, 3, 9, 7};
+    const auto b = flat_set<int>{3, 4, 5, 6};
+    display_set(a & b);
+    display_set(a | b);
+    display_set(a ^ b);
+    display_set(a / b);
+    std::cout << std::boolalpha << ((a & b) < a) << ' ' << (a / b + (a & b) == a) << '\n';
+
+    // every kernel must agree with std::ranges::set_intersection
+    auto gen = std::mt19937{42};
+    auto ok  = true;
+    const auto sizes = {std::pair{1000, 1000}, {50, 100000}, {777, 3333}, {0, 5}};
+    for (const auto &[m, n] : sizes) {
+        const auto x = random_set(m, 1 << 17, gen);
+        const auto y = random_set(n, 1 << 17, gen);
+        auto expect  = std::vector<int>{};
+        std::ranges::set_intersection(x, y, std::back_inserter(expect));
+        ok = ok && (x & y).values() == expect && (y & x).values() == expect;
+    }
+    std::cout << "agree: " << ok << '\n';
+
+    const auto big0   = random_set(1 << 20, 1 << 22, gen);
+    const auto big1   = random_set(1 << 20, 1 << 22, gen);
+    const auto small  = random_set(1 << 10, 1 << 22, gen);
+    const auto tree0  = std::set<int>(big0.begin(), big0.end());
+    const auto tree1  = std::set<int>(big1.begin(), big1.end());
+    const auto tree_s = std::set<int>(small.begin(), small.end());
+    const auto tree_and = [](const std::set<int> &x, const std::set<int> &y) {
+        auto result = std::set<int>{};
+        std::ranges::set_intersection(x, y, std::inserter(result, result.end()));
+        return result.size();
+    };
+    measure<64>("flat_set  balanced", [&] { return (big0 & big1).size(); });
+    measure<64>("std::set  balanced", [&] { return tree_and(tree0, tree1); });
+    measure<64>("flat_set  skewed  ", [&] { return (small & big0).size(); });
+    measure<64>("std::set  skewed  ", [&] { return tree_and(tree_s, tree0); });
+
+    // three temporaries and four passes, against one merge over the three sets
+    measure<64>("flat_set  (a & b) | (a ^ c)      ", [&] {
+        return ((big0 & big1) | (big0 ^ small)).size();
+    });
+    measure<64>("flat_set  lazy (a & b) | (a ^ c) ", [&] {
+        return evaluate((lazy(big0) & big1) | (lazy(big0) ^ small)).size();
+    });
+}
@@ -0,0 +1,378 @@
+#pragma once
+#include "sets.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+inline namespace set_operation {
+
+namespace __detail {
+
+// above this size ratio, intersect by searching the larger set instead of merging
+inline constexpr auto kGallopRatio = std::size_t{32};
+
+/* First position in [first, last) not less than value, probing 1, 2, 4, ... ahead. */
+template <typename _Tp>
+inline auto gallop(const _Tp *first, const _Tp *last, const _Tp &value) -> const _Tp * {
+    auto step = std::size_t{1};
+    auto *low = first;
+    while (static_cast<std::size_t>(last - low) > step && low[step] < value) {
+        low += step;
+        step *= 2;
+    }
+    const auto *high = low + std::min(step + 1, static_cast<std::size_t>(last - low));
+    return std::lower_bound(low, high, value);
+}
+
+template <typename _Tp>
+inline auto intersect_gallop(
+    const _Tp *small, std::size_t m, const _Tp *large, std::size_t n, _Tp *out
+) -> _Tp * {
+    const auto *last = large + n;
+    for (std::size_t i = 0; i < m && large != last; ++i) {
+        large = gallop(large, last, small[i]);
+        if (large != last && *large == small[i])
+            *out++ = *large++;
+    }
+    return out;
+}
+
+template <typename _Tp>
+inline auto intersect_merge(
+    const _Tp *a, std::size_t m, const _Tp *b, std::size_t n, _Tp *out
+) -> _Tp * {
+    const auto *a_end = a + m;
+    const auto *b_end = b + n;
+    while (a != a_end && b != b_end) {
+        if (*a < *b) {
+            ++a;
+        } else if (*b < *a) {
+            ++b;
+        } else {
+            *out++ = *a++;
+            ++b;
+        }
+    }
+    return out;
+}
+
+template <typename _Tp>
+concept simd_key = std::integral<_Tp> && sizeof(_Tp) == 4;
+
+#if defined(__AVX512F__)
+/**
+ * Compare blocks of 16 keys all against all, by rotating one block 15 times.
+ * The matches of a are compressed straight into out.
+ */
+template <simd_key _Tp>
+inline auto intersect_simd(
+    const _Tp *a, std::size_t m, const _Tp *b, std::size_t n, _Tp *out
+) -> _Tp * {
+    auto i = std::size_t{};
+    auto j = std::size_t{};
+    while (i + 16 <= m && j + 16 <= n) {
+        const auto va     = _mm512_loadu_si512(a + i);
+        const auto rotate =
+            _mm512_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0);
+        auto vb           = _mm512_loadu_si512(b + j);
+        auto mask         = _mm512_cmpeq_epi32_mask(va, vb);
+        for (int k = 1; k < 16; ++k) {
+            // full mask: the unmasked form trips -Wuninitialized in GCC 12 headers
+            vb = _mm512_mask_permutexvar_epi32(vb, 0xffff, rotate, vb);
+            mask |= _mm512_cmpeq_epi32_mask(va, vb);
+        }
+        _mm512_mask_compressstoreu_epi32(out, mask, va);
+        out += std::popcount(static_cast<unsigned>(mask));
+        const auto a_max = a[i + 15];
+        const auto b_max = b[j + 15];
+        i += a_max <= b_max ? 16 : 0;
+        j += b_max <= a_max ? 16 : 0;
+    }
+    return intersect_merge(a + i, m - i, b + j, n - j, out);
+}
+#elif defined(__AVX2__)
+// for each 8-bit mask, the lanes to gather to pack the selected lanes first
+inline constexpr auto kPackTable = [] {
+    auto table = std::array<std::array<std::int32_t, 8>, 256>{};
+    for (std::size_t mask = 0; mask < 256; ++mask) {
+        auto k = std::size_t{};
+        for (std::int32_t lane = 0; lane < 8; ++lane)
+            if (mask >> lane & 1)
+                table[mask][k++] = lane;
+    }
+    return table;
+}();
+
+/**
+ * Compare blocks of 8 keys all against all, by rotating one block 7 times.
+ * The matches of a are packed with a shuffle from kPackTable.
+ */
+template <simd_key _Tp>
+inline auto intersect_simd(
+    const _Tp *a, std::size_t m, const _Tp *b, std::size_t n, _Tp *out
+) -> _Tp * {
+    const auto load = [](const _Tp *ptr) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr));
+    };
+    auto i = std::size_t{};
+    auto j = std::size_t{};
+    while (i + 8 <= m && j + 8 <= n) {
+        const auto va     = load(a + i);
+        const auto rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+        auto vb           = load(b + j);
+        auto hits         = _mm256_cmpeq_epi32(va, vb);
+        for (int k = 1; k < 8; ++k) {
+            vb   = _mm256_permutevar8x32_epi32(vb, rotate);
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi32(va, vb));
+        }
+        const auto bits  = _mm256_movemask_ps(_mm256_castsi256_ps(hits));
+        const auto mask  = static_cast<unsigned>(bits);
+        const auto *lane = kPackTable[mask].data();
+        const auto index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lane));
+        const auto pack  = _mm256_permutevar8x32_epi32(va, index);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), pack);
+        out += std::popcount(mask);
+        const auto a_max = a[i + 7];
+        const auto b_max = b[j + 7];
+        i += a_max <= b_max ? 8 : 0;
+        j += b_max <= a_max ? 8 : 0;
+    }
+    return intersect_merge(a + i, m - i, b + j, n - j, out);
+}
+#endif
+
+template <typename _Tp>
+inline auto intersect(const _Tp *a, std::size_t m, const _Tp *b, std::size_t n, _Tp *out)
+    -> _Tp * {
+    if (m > n)
+        return intersect(b, n, a, m, out);
+    if (m == 0)
+        return out;
+    if (n / m >= kGallopRatio)
+        return intersect_gallop(a, m, b, n, out);
+#if defined(__AVX2__) || defined(__AVX512F__)
+    if constexpr (simd_key<_Tp>)
+        return intersect_simd(a, m, b, n, out);
+#endif
+    return intersect_merge(a, m, b, n, out);
+}
+
+} // namespace __detail
+
+/**
+ * A set backed by one sorted vector, without duplicates.
+ * Intersection gallops through the larger set when the sizes are skewed,
+ * and compares whole blocks with AVX-512 or AVX2 for 32-bit integer keys.
+ * The other operations are linear merges into a single allocation.
+ * Compound assignments merge in place: & and / compact the vector, while
+ * | and ^ merge from the back into its grown tail.
+ */
+template <std::totally_ordered _Tp>
+struct flat_set {
+public:
+    using value_type     = _Tp;
+    using const_iterator = typename std::vector<_Tp>::const_iterator;
+
+    struct sorted_unique_t {};
+
+    static constexpr auto sorted_unique = sorted_unique_t{};
+
+    flat_set() = default;
+
+    flat_set(std::initializer_list<_Tp> list) : flat_set(std::vector<_Tp>(list)) {}
+
+    explicit flat_set(std::vector<_Tp> values) : _M_data(std::move(values)) {
+        std::ranges::sort(_M_data);
+        const auto [first, last] = std::ranges::unique(_M_data);
+        _M_data.erase(first, last);
+    }
+
+    /* Adopt values that are already sorted and unique, without checking. */
+    flat_set(sorted_unique_t, std::vector<_Tp> values) : _M_data(std::move(values)) {}
+
+    auto contains(const _Tp &value) const -> bool {
+        return std::ranges::binary_search(_M_data, value);
+    }
+
+    auto insert(const _Tp &value) -> bool {
+        const auto iter = std::ranges::lower_bound(_M_data, value);
+        if (iter != _M_data.end() && *iter == value)
+            return false;
+        _M_data.insert(iter, value);
+        return true;
+    }
+
+    auto erase(const _Tp &value) -> bool {
+        const auto iter = std::ranges::lower_bound(_M_data, value);
+        if (iter == _M_data.end() || *iter != value)
+            return false;
+        _M_data.erase(iter);
+        return true;
+    }
+
+    auto size() const -> std::size_t {
+        return _M_data.size();
+    }
+
+    auto empty() const -> bool {
+        return _M_data.empty();
+    }
+
+    auto begin() const -> const_iterator {
+        return _M_data.begin();
+    }
+
+    auto end() const -> const_iterator {
+        return _M_data.end();
+    }
+
+    auto data() const -> const _Tp * {
+        return _M_data.data();
+    }
+
+    auto values() const & -> const std::vector<_Tp> & {
+        return _M_data;
+    }
+
+    auto values() && -> std::vector<_Tp> {
+        return std::move(_M_data);
+    }
+
+    auto operator&=(const flat_set &rhs) -> flat_set & {
+        return this->_M_filter<true>(rhs);
+    }
+
+    auto operator|=(const flat_set &rhs) -> flat_set & {
+        return this->_M_merge_back<false>(rhs);
+    }
+
+    auto operator^=(const flat_set &rhs) -> flat_set & {
+        return this->_M_merge_back<true>(rhs);
+    }
+
+    auto operator/=(const flat_set &rhs) -> flat_set & {
+        return this->_M_filter<false>(rhs);
+    }
+
+    friend auto operator&(const flat_set &a, const flat_set &b) -> flat_set {
+        // the SIMD kernels store whole blocks past the end
+        const auto size = std::min(a.size(), b.size()) + __detail::kSetSlack;
+        auto result     = std::vector<_Tp>(size);
+        const auto *last =
+            __detail::intersect(a.data(), a.size(), b.data(), b.size(), result.data());
+        result.resize(static_cast<std::size_t>(last - result.data()));
+        return flat_set{sorted_unique, std::move(result)};
+    }
+
+    friend auto operator|(const flat_set &a, const flat_set &b) -> flat_set {
+        return _S_merge(a, b, a.size() + b.size(), std::ranges::set_union);
+    }
+
+    friend auto operator^(const flat_set &a, const flat_set &b) -> flat_set {
+        return _S_merge(a, b, a.size() + b.size(), std::ranges::set_symmetric_difference);
+    }
+
+    friend auto operator/(const flat_set &a, const flat_set &b) -> flat_set {
+        return _S_merge(a, b, a.size(), std::ranges::set_difference);
+    }
+
+    friend auto operator==(const flat_set &, const flat_set &) -> bool = default;
+
+private:
+    template <typename _Merge>
+    static auto _S_merge(
+        const flat_set &a, const flat_set &b, std::size_t n, _Merge merge
+    ) -> flat_set {
+        auto result = std::vector<_Tp>{};
+        result.reserve(n);
+        merge(a._M_data, b._M_data, std::back_inserter(result));
+        return flat_set{sorted_unique, std::move(result)};
+    }
+
+    // keep the elements which are in rhs, or those which are not
+    template <bool _Found>
+    auto _M_filter(const flat_set &rhs) -> flat_set & {
+        if (this == &rhs) {
+            if constexpr (!_Found)
+                _M_data.clear();
+            return *this;
+        }
+        auto iter = rhs._M_data.begin();
+        std::erase_if(_M_data, [&iter, &rhs](const _Tp &value) {
+            while (iter != rhs._M_data.end() && *iter < value)
+                ++iter;
+            return (iter != rhs._M_data.end() && *iter == value) != _Found;
+        });
+        return *this;
+    }
+
+    // from the largest elements down, writing above the unread part of this
+    template <bool _Xor>
+    auto _M_merge_back(const flat_set &rhs) -> flat_set & {
+        if (this == &rhs) {
+            if constexpr (_Xor)
+                _M_data.clear();
+            return *this;
+        }
+        auto i = _M_data.size();
+        auto j = rhs._M_data.size();
+        auto w = i + j;
+        _M_data.resize(w);
+        while (i != 0 && j != 0) {
+            const auto &x = _M_data[i - 1];
+            const auto &y = rhs._M_data[j - 1];
+            if (y < x) {
+                --i;
+                _M_data[--w] = std::move(_M_data[i]);
+            } else if (x < y) {
+                _M_data[--w] = rhs._M_data[--j];
+            } else {
+                --i;
+                --j;
+                if constexpr (!_Xor)
+                    _M_data[--w] = std::move(_M_data[i]);
+            }
+        }
+        while (j != 0)
+            _M_data[--w] = rhs._M_data[--j];
+        // equal pairs left a gap between the unmerged head and the merged tail
+        _M_data.erase(_M_data.begin() + i, _M_data.begin() + w);
+        return *this;
+    }
+
+    std::vector<_Tp> _M_data;
+};
+
+template <typename _Tp>
+struct set_op_traits<flat_set<_Tp>> : std::true_type {
+    static constexpr auto in_place = set_in_place{true, true, true, true};
+};
+
+template <typename _Tp>
+struct sorted_set_traits<flat_set<_Tp>> : std::true_type {
+    static auto from_sorted(std::vector<_Tp> &&values) -> flat_set<_Tp> {
+        return flat_set<_Tp>{flat_set<_Tp>::sorted_unique, std::move(values)};
+    }
+
+    static auto intersect(
+        const _Tp *a, std::size_t m, const _Tp *b, std::size_t n, _Tp *out
+    ) -> _Tp * {
+        return __detail::intersect(a, m, b, n, out);
+    }
+};
+
+} // namespace set_operation
@@ -0,0 +1,76 @@
+#include "../bench/timing.h"
+#include "interval.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+
+template <typename _Tp>
+auto display_set(const interval_set<_Tp> &set) -> void {
+    std::cout << "{ ";
+    for (const auto &[lo, hi] : set)
+        std::cout << '[' << +lo << ", " << +hi << ") "; // + prints 8-bit ones as numbers
+    std::cout << "}" << std::endl;
+}
+
+/* Runs of up to length ids each, such as booked time ranges. */
+auto random_runs(std::size_t runs, std::uint32_t length, std::mt19937 &gen)
+    -> interval_set<std::uint32_t> {
+    auto start  = std::uniform_int_distribution<std::uint32_t>(0, 1u << 30);
+    auto size   = std::uniform_int_distribution<std::uint32_t>(1, length);
+    auto result = interval_set<std::uint32_t>{};
+    for (std::size_t i = 0; i < runs; ++i) {
+        const auto lo = start(gen);
+        result.insert(lo, lo + size(gen));
+    }
+    return result;
+}
+
+auto to_tree(const interval_set<std::uint32_t> &set) -> std::set<std::uint32_t> {
+    auto result = std::set<std::uint32_t>{};
+    set.for_each([&result](std::uint32_t value) { result.insert(result.end(), value); });
+    return result;
+}
+
+auto main() -> int {
+    const auto a = interval_set<int>{{0, 10}, {20, 30}, {10, 12}};
+    const auto b = interval_set<int>{{5, 25}, {40, 50}};
+    display_set(a & b);
+    display_set(a | b);
+    display_set(a ^ b);
+    display_set(a / b);
+    display_set(~interval_set<std::uint8_t>{{0, 16}, {32, 64}});
+    std::cout << std::boolalpha;
+    std::cout << ((a & b) < a) << ' ' << (a <= b) << ' ';
+    std::cout << ((a / b) + (a & b) == a) << '\n';
+
+    // 2000 runs of up to 1000 ids: about 20 bytes per run against 40 per id
+    auto gen     = std::mt19937{42};
+    const auto x = random_runs(2000, 1000, gen);
+    const auto y = random_runs(2000, 1000, gen);
+    std::cout << x.runs() << " runs, " << x.count() << " ids, " << x.memory_usage()
+              << " bytes\n";
+
+    const auto tx       = to_tree(x);
+    const auto ty       = to_tree(y);
+    const auto tree_and = [&] {
+        auto result = std::set<std::uint32_t>{};
+        std::ranges::set_intersection(tx, ty, std::inserter(result, result.end()));
+        return result.size();
+    };
+    const auto tree_or = [&] {
+        auto result = std::set<std::uint32_t>{};
+        std::ranges::set_union(tx, ty, std::inserter(result, result.end()));
+        return result.size();
+    };
+    measure<16>("interval  &", [&] { return static_cast<std::size_t>((x & y).count()); });
+    measure<16>("std::set  &", tree_and);
+    measure<16>("interval  |", [&] { return static_cast<std::size_t>((x | y).count()); });
+    measure<16>("std::set  |", tree_or);
+    measure<16>("interval  /", [&] { return static_cast<std::size_t>((x / y).count()); });
+    measure<16>("interval  ^", [&] { return static_cast<std::size_t>((x ^ y).count()); });
+}
@@ -0,0 +1,206 @@
+#pragma once
+#include "sets.h"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+inline namespace set_operation {
+
+/**
+ * A set of integers stored as sorted, disjoint runs [lo, hi), which never touch.
+ * &, |, / and ~ are linear merges over the runs, so both memory and time scale
+ * with the number of runs rather than of elements. ~ is taken within the
+ * universe [min, max) of _Tp. ^ and the comparison come from set_op_traits.
+ */
+template <std::integral _Tp>
+struct interval_set {
+public:
+    struct interval {
+        _Tp lo;
+        _Tp hi;
+
+        friend auto operator==(const interval &, const interval &) -> bool = default;
+    };
+
+    using value_type     = interval;
+    using const_iterator = typename std::vector<interval>::const_iterator;
+
+    interval_set() = default;
+
+    /* Runs in any order. They may overlap, touch or be empty. */
+    interval_set(std::initializer_list<interval> list) {
+        auto runs = std::vector<interval>(list);
+        std::ranges::sort(runs, {}, &interval::lo);
+        for (const auto &run : runs)
+            if (run.lo < run.hi)
+                this->_M_append(run);
+    }
+
+    auto contains(_Tp value) const -> bool {
+        const auto iter = std::ranges::upper_bound(_M_runs, value, {}, &interval::lo);
+        return iter != _M_runs.begin() && value < std::prev(iter)->hi;
+    }
+
+    /* Add [lo, hi), merging the runs which overlap or touch it. */
+    auto insert(_Tp lo, _Tp hi) -> void {
+        if (!(lo < hi))
+            return;
+        const auto first = std::ranges::lower_bound(_M_runs, lo, {}, &interval::hi);
+        const auto last  = std::ranges::upper_bound(_M_runs, hi, {}, &interval::lo);
+        if (first != last) {
+            lo = std::min(lo, first->lo);
+            hi = std::max(hi, std::prev(last)->hi);
+        }
+        _M_runs.insert(_M_runs.erase(first, last), interval{lo, hi});
+    }
+
+    /* Remove [lo, hi), cutting the runs at its ends. */
+    auto erase(_Tp lo, _Tp hi) -> void {
+        if (!(lo < hi))
+            return;
+        const auto first = std::ranges::upper_bound(_M_runs, lo, {}, &interval::hi);
+        const auto last  = std::ranges::lower_bound(_M_runs, hi, {}, &interval::lo);
+        if (first == last)
+            return;
+        const auto head = interval{first->lo, lo};
+        const auto tail = interval{hi, std::prev(last)->hi};
+        auto iter       = _M_runs.erase(first, last);
+        if (tail.lo < tail.hi)
+            iter = _M_runs.insert(iter, tail);
+        if (head.lo < head.hi)
+            _M_runs.insert(iter, head);
+    }
+
+    /* These require value < max(). */
+
+    auto insert(_Tp value) -> void {
+        this->insert(value, static_cast<_Tp>(value + 1));
+    }
+
+    auto erase(_Tp value) -> void {
+        this->erase(value, static_cast<_Tp>(value + 1));
+    }
+
+    /* The number of elements, which can't overflow as the universe excludes max(). */
+    auto count() const -> std::uintmax_t {
+        using _Wide = std::uintmax_t;
+        auto total  = _Wide{};
+        for (const auto &run : _M_runs)
+            total += static_cast<_Wide>(run.hi) - static_cast<_Wide>(run.lo);
+        return total;
+    }
+
+    auto runs() const -> std::size_t {
+        return _M_runs.size();
+    }
+
+    auto empty() const -> bool {
+        return _M_runs.empty();
+    }
+
+    auto begin() const -> const_iterator {
+        return _M_runs.begin();
+    }
+
+    auto end() const -> const_iterator {
+        return _M_runs.end();
+    }
+
+    /* Call fn(value) for each element, in increasing order. */
+    template <typename _Fn>
+    auto for_each(_Fn &&fn) const -> void {
+        for (const auto &run : _M_runs)
+            for (auto value = run.lo; value != run.hi; ++value)
+                fn(value);
+    }
+
+    auto memory_usage() const -> std::size_t {
+        return sizeof(*this) + _M_runs.capacity() * sizeof(interval);
+    }
+
+    friend auto operator&(const interval_set &a, const interval_set &b) -> interval_set {
+        auto result = interval_set{};
+        auto x      = a.begin();
+        auto y      = b.begin();
+        while (x != a.end() && y != b.end()) {
+            const auto lo = std::max(x->lo, y->lo);
+            const auto hi = std::min(x->hi, y->hi);
+            if (lo < hi)
+                result._M_runs.push_back({lo, hi});
+            if (x->hi < y->hi)
+                ++x;
+            else
+                ++y;
+        }
+        return result;
+    }
+
+    friend auto operator|(const interval_set &a, const interval_set &b) -> interval_set {
+        auto result = interval_set{};
+        result._M_runs.reserve(a.runs() + b.runs());
+        auto x = a.begin();
+        auto y = b.begin();
+        while (x != a.end() || y != b.end()) {
+            if (y == b.end() || (x != a.end() && x->lo < y->lo))
+                result._M_append(*x++);
+            else
+                result._M_append(*y++);
+        }
+        return result;
+    }
+
+    friend auto operator/(const interval_set &a, const interval_set &b) -> interval_set {
+        auto result = interval_set{};
+        auto y      = b.begin();
+        for (auto run : a._M_runs) {
+            // runs of b which end before this one can't cut any later run either
+            while (y != b.end() && !(run.lo < y->hi))
+                ++y;
+            for (auto z = y; z != b.end() && z->lo < run.hi && run.lo < run.hi; ++z) {
+                if (run.lo < z->lo)
+                    result._M_runs.push_back({run.lo, z->lo});
+                run.lo = std::max(run.lo, z->hi);
+            }
+            if (run.lo < run.hi)
+                result._M_runs.push_back(run);
+        }
+        return result;
+    }
+
+    friend auto operator~(const interval_set &a) -> interval_set {
+        auto result = interval_set{};
+        auto lo     = std::numeric_limits<_Tp>::min();
+        for (const auto &run : a._M_runs) {
+            if (lo < run.lo)
+                result._M_runs.push_back({lo, run.lo});
+            lo = run.hi;
+        }
+        if (lo < std::numeric_limits<_Tp>::max())
+            result._M_runs.push_back({lo, std::numeric_limits<_Tp>::max()});
+        return result;
+    }
+
+    friend auto operator==(const interval_set &, const interval_set &) -> bool = default;
+
+private:
+    // append a run which starts no earlier than the last one, merging if they meet
+    auto _M_append(const interval &run) -> void {
+        if (!_M_runs.empty() && !(_M_runs.back().hi < run.lo))
+            _M_runs.back().hi = std::max(_M_runs.back().hi, run.hi);
+        else
+            _M_runs.push_back(run);
+    }
+
+    std::vector<interval> _M_runs;
+};
+
+template <std::integral _Tp>
+struct set_op_traits<interval_set<_Tp>> : std::true_type {};
+
+} // namespace set_operation
@@ -0,0 +1,64 @@
+#include "../bench/timing.h"
+#include "flat.h"
+#include "par.h"
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <iostream>
+#include <random>
+#include <ratio>
+#include <thread>
+#include <vector>
+
+auto random_set(std::size_t n, std::mt19937 &gen) -> flat_set<std::uint32_t> {
+    auto dist   = std::uniform_int_distribution<std::uint32_t>(0, 1u << 28);
+    auto values = std::vector<std::uint32_t>(n);
+    for (auto &value : values)
+        value = dist(gen);
+    return flat_set<std::uint32_t>{std::move(values)};
+}
+
+auto main() -> int {
+    auto gen     = std::mt19937{42};
+    const auto a = random_set(1 << 24, gen);
+    const auto b = random_set(1 << 24, gen);
+    auto x       = dynamic_bitset{1 << 28};
+    auto y       = dynamic_bitset{(1 << 28) + 100};
+    for (const auto value : a)
+        x.insert(value % x.universe());
+    for (const auto value : b)
+        y.insert(value % y.universe());
+
+    std::cout << std::boolalpha;
+    std::cout << "threads: " << std::thread::hardware_concurrency() << '\n';
+    std::cout << "agree: "
+              << (parallel_and(a, b) == (a & b) && parallel_or(a, b) == (a | b) &&
+                  parallel_xor(a, b) == (a ^ b) && parallel_sub(a, b) == (a / b) &&
+                  parallel_and(x, y) == (x & y) && parallel_sub(y, x) == (y / x) &&
+                  parallel_count(x) == x.count())
+              << '\n';
+
+    // the same work, on one thread and then on every core
+    measure<4, std::milli>("flat_set     &  serial", [&] {
+        return parallel_and(a, b, 1).size();
+    });
+    measure<4, std::milli>("flat_set     &  parallel", [&] {
+        return parallel_and(a, b).size();
+    });
+    measure<4, std::milli>("flat_set     |  serial", [&] {
+        return parallel_or(a, b, 1).size();
+    });
+    measure<4, std::milli>("flat_set     |  parallel", [&] {
+        return parallel_or(a, b).size();
+    });
+    measure<4, std::milli>("bitset       |  serial", [&] {
+        return parallel_or(x, y, 1).count();
+    });
+    measure<4, std::milli>("bitset       |  parallel", [&] {
+        return parallel_or(x, y).count();
+    });
+    measure<4, std::milli>("bitset count    serial", [&] {
+        return parallel_count(x, 1);
+    });
+    measure<4, std::milli>("bitset count    parallel", [&] { return parallel_count(x); });
+}
@@ -0,0 +1,269 @@
+#pragma once
+#include "dense.h"
+#include "sets.h"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <ranges>
+#include <thread>
+#include <utility>
+#include <vector>
+
+inline namespace set_operation {
+
+namespace __detail {
+
+inline constexpr auto kParallelMin = std::size_t{1} << 16; // elements or words per thread
+inline constexpr auto kLineWords   = std::size_t{8};       // words in a cache line
+
+inline auto default_threads() -> std::size_t {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// how many threads are worth starting for n elements or words
+inline auto parallel_threads(std::size_t n, std::size_t threads) -> std::size_t {
+    if (threads == 0)
+        threads = default_threads();
+    return std::clamp<std::size_t>(n / kParallelMin, 1, threads);
+}
+
+/* Run fn(k) for each k in [0, tasks), one thread each, the caller taking k = 0. */
+template <typename _Fn>
+inline auto parallel_tasks(std::size_t tasks, _Fn &&fn) -> void {
+    auto errors     = std::vector<std::exception_ptr>(tasks);
+    const auto work = [&fn, &errors](std::size_t k) {
+        try {
+            fn(k);
+        } catch (...) {
+            errors[k] = std::current_exception();
+        }
+    };
+
+    {
+        auto workers = std::vector<std::jthread>{};
+        workers.reserve(tasks);
+        for (std::size_t k = 1; k < tasks; ++k)
+            workers.emplace_back(work, k);
+        work(0);
+    }
+
+    for (auto &error : errors)
+        if (error != nullptr)
+            std::rethrow_exception(error);
+}
+
+template <typename _Tp>
+concept parallel_bitset = word_set_like<_Tp> || std::same_as<_Tp, dynamic_bitset>;
+
+template <typename _Tp>
+concept parallel_sorted_set =
+    sorted_set_like<_Tp> && std::ranges::contiguous_range<const _Tp>;
+
+template <set_expr_op _Op>
+inline constexpr auto kBitOp = _Op == set_expr_op::op_and   ? bit_op::bit_and
+                               : _Op == set_expr_op::op_or  ? bit_op::bit_or
+                               : _Op == set_expr_op::op_xor ? bit_op::bit_xor
+                                                            : bit_op::bit_andnot;
+
+template <parallel_bitset _Tp>
+inline auto words_of(const _Tp &a) -> std::size_t {
+    if constexpr (word_set_like<_Tp>)
+        return word_set_traits<_Tp>::words;
+    else
+        return words_for(a.universe());
+}
+
+// the k-th of tasks boundaries in n words, on cache lines so no line has two writers
+inline auto line_split(std::size_t n, std::size_t k, std::size_t tasks) -> std::size_t {
+    return k == tasks ? n : n / kLineWords * k / tasks * kLineWords;
+}
+
+/* Bitsets split by word range. The result starts zeroed, which covers the tails of &. */
+template <set_expr_op _Op, parallel_bitset _Tp>
+inline auto parallel_words(const _Tp &a, const _Tp &b, std::size_t tasks) -> _Tp {
+    auto result = [&a, &b] {
+        if constexpr (word_set_like<_Tp>)
+            return _Tp{};
+        else
+            return _Tp{std::max(a.universe(), b.universe())};
+    }();
+
+    // words past the shorter operand: 0 for &, and for a / b past a, else the longer ones
+    const auto &longer = words_of(a) >= words_of(b) ? a : b;
+    const auto common  = std::min(words_of(a), words_of(b));
+    const auto total   = words_of(longer);
+    const auto zero    = _Op == set_expr_op::op_and ||
+                      (_Op == set_expr_op::op_sub && &longer != &a);
+    parallel_tasks(tasks, [&](std::size_t k) {
+        const auto from = line_split(total, k, tasks);
+        const auto to   = line_split(total, k + 1, tasks);
+        const auto mid  = std::clamp(common, from, to);
+        // past the shorter operand, an offset of from would point out of its bounds
+        if (mid > from)
+            bit_apply<kBitOp<_Op>>(
+                result.data() + from, a.data() + from, b.data() + from, mid - from
+            );
+        if (!zero)
+            std::copy(longer.data() + mid, longer.data() + to, result.data() + mid);
+    });
+    return result;
+}
+
+/**
+ * The split (i, d - i) of the first d elements in the merge of a and b, taking
+ * a first on ties. An equal pair across the split moves wholly before it, so
+ * that one part sees both copies of an element.
+ */
+template <typename _Value>
+inline auto co_rank(
+    const _Value *a, std::size_t m, const _Value *b, std::size_t n, std::size_t d
+) -> std::pair<std::size_t, std::size_t> {
+    // the largest i with a[i - 1] <= b[d - i]
+    auto lo = d > n ? d - n : 0;
+    auto hi = std::min(d, m);
+    while (lo < hi) {
+        const auto mid = lo + (hi - lo + 1) / 2;
+        if (b[d - mid] < a[mid - 1])
+            hi = mid - 1;
+        else
+            lo = mid;
+    }
+    const auto i = lo;
+    const auto j = d - lo;
+    if (i != 0 && j != n && !(a[i - 1] < b[j]))
+        return {i, j + 1};
+    return {i, j};
+}
+
+template <set_expr_op _Op, typename _Tp, typename _Value>
+inline auto merge_part(const _Value *a, std::size_t m, const _Value *b, std::size_t n)
+    -> std::vector<_Value> {
+    const auto x = std::ranges::subrange(a, a + m);
+    const auto y = std::ranges::subrange(b, b + n);
+    auto result  = std::vector<_Value>{};
+    if constexpr (_Op == set_expr_op::op_and && set_intersect_kernel<_Tp, const _Tp>) {
+        result.resize(std::min(m, n) + kSetSlack);
+        const auto *last = sorted_set_traits<_Tp>::intersect(a, m, b, n, result.data());
+        result.resize(static_cast<std::size_t>(last - result.data()));
+    } else if constexpr (_Op == set_expr_op::op_and) {
+        result.reserve(std::min(m, n));
+        std::ranges::set_intersection(x, y, std::back_inserter(result));
+    } else if constexpr (_Op == set_expr_op::op_or) {
+        result.reserve(m + n);
+        std::ranges::set_union(x, y, std::back_inserter(result));
+    } else if constexpr (_Op == set_expr_op::op_xor) {
+        result.reserve(m + n);
+        std::ranges::set_symmetric_difference(x, y, std::back_inserter(result));
+    } else {
+        result.reserve(m);
+        std::ranges::set_difference(x, y, std::back_inserter(result));
+    }
+    return result;
+}
+
+/**
+ * Sorted sets split by merge path: the k-th thread takes the k-th equal share
+ * of the merged sequence, found by co-ranking, into a buffer of its own.
+ * The buffers are then copied in parallel into the result.
+ */
+template <set_expr_op _Op, parallel_sorted_set _Tp>
+inline auto parallel_merge(const _Tp &a, const _Tp &b, std::size_t tasks) -> _Tp {
+    using _Value  = std::ranges::range_value_t<const _Tp>;
+    const auto *x = std::ranges::data(a);
+    const auto *y = std::ranges::data(b);
+    const auto m  = static_cast<std::size_t>(std::ranges::size(a));
+    const auto n  = static_cast<std::size_t>(std::ranges::size(b));
+
+    auto splits = std::vector<std::pair<std::size_t, std::size_t>>{};
+    for (std::size_t k = 0; k <= tasks; ++k)
+        splits.push_back(co_rank(x, m, y, n, (m + n) * k / tasks));
+
+    auto parts = std::vector<std::vector<_Value>>(tasks);
+    parallel_tasks(tasks, [&](std::size_t k) {
+        const auto [i0, j0] = splits[k];
+        const auto [i1, j1] = splits[k + 1];
+        parts[k]            = merge_part<_Op, _Tp>(x + i0, i1 - i0, y + j0, j1 - j0);
+    });
+
+    auto offsets = std::vector<std::size_t>{0};
+    for (const auto &part : parts)
+        offsets.push_back(offsets.back() + part.size());
+    auto result = std::vector<_Value>(offsets.back());
+    parallel_tasks(tasks, [&](std::size_t k) {
+        const auto offset = static_cast<std::ptrdiff_t>(offsets[k]);
+        std::ranges::move(parts[k], result.begin() + offset);
+    });
+    return sorted_set_traits<_Tp>::from_sorted(std::move(result));
+}
+
+template <typename _Tp>
+concept parallel_set_like_ = parallel_bitset<_Tp> || parallel_sorted_set<_Tp>;
+
+template <set_expr_op _Op, typename _Tp>
+inline auto parallel_apply(const _Tp &a, const _Tp &b, std::size_t threads) -> _Tp {
+    if constexpr (parallel_bitset<_Tp>) {
+        const auto words = std::max(words_of(a), words_of(b));
+        const auto tasks = parallel_threads(words, threads);
+        if (tasks == 1)
+            return apply_set_op<_Op>(a, b);
+        return parallel_words<_Op>(a, b, tasks);
+    } else {
+        const auto size  = std::ranges::size(a) + std::ranges::size(b);
+        const auto tasks = parallel_threads(static_cast<std::size_t>(size), threads);
+        if (tasks == 1)
+            return apply_set_op<_Op>(a, b);
+        return parallel_merge<_Op>(a, b, tasks);
+    }
+}
+
+} // namespace __detail
+
+/**
+ * Bitsets, split by word range, and sorted sets over contiguous storage,
+ * split by merge path. Small inputs stay on the calling thread.
+ */
+template <typename _Tp>
+concept parallel_set_like = __detail::parallel_set_like_<_Tp>;
+
+/* These use up to threads threads, or one per core when threads is 0. */
+
+template <parallel_set_like _Tp>
+inline auto parallel_and(const _Tp &a, const _Tp &b, std::size_t threads = 0) -> _Tp {
+    return __detail::parallel_apply<__detail::set_expr_op::op_and>(a, b, threads);
+}
+
+template <parallel_set_like _Tp>
+inline auto parallel_or(const _Tp &a, const _Tp &b, std::size_t threads = 0) -> _Tp {
+    return __detail::parallel_apply<__detail::set_expr_op::op_or>(a, b, threads);
+}
+
+template <parallel_set_like _Tp>
+inline auto parallel_xor(const _Tp &a, const _Tp &b, std::size_t threads = 0) -> _Tp {
+    return __detail::parallel_apply<__detail::set_expr_op::op_xor>(a, b, threads);
+}
+
+template <parallel_set_like _Tp>
+inline auto parallel_sub(const _Tp &a, const _Tp &b, std::size_t threads = 0) -> _Tp {
+    return __detail::parallel_apply<__detail::set_expr_op::op_sub>(a, b, threads);
+}
+
+/* The number of elements, as partial popcounts over word ranges. */
+template <__detail::parallel_bitset _Tp>
+inline auto parallel_count(const _Tp &a, std::size_t threads = 0) -> std::size_t {
+    const auto words = __detail::words_of(a);
+    const auto tasks = __detail::parallel_threads(words, threads);
+    auto counts      = std::vector<std::size_t>(tasks);
+    __detail::parallel_tasks(tasks, [&](std::size_t k) {
+        const auto from = __detail::line_split(words, k, tasks);
+        const auto to   = __detail::line_split(words, k + 1, tasks);
+        counts[k]       = __detail::bit_count(a.data() + from, to - from);
+    });
+    auto total = std::size_t{};
+    for (const auto count : counts)
+        total += count;
+    return total;
+}
+
+} // namespace set_operation
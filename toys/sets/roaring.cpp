@@ -0,0 +1,118 @@
+#include "../bench/timing.h"
+#include "roaring.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string_view>
+#include <vector>
+
+auto display_set(const roaring_bitmap &set) -> void {
+    std::cout << "{ ";
+    set.for_each([](std::uint32_t elem) { std::cout << elem << ' '; });
+    std::cout << "}" << std::endl;
+}
+
+auto to_vector(const roaring_bitmap &set) -> std::vector<std::uint32_t> {
+    auto result = std::vector<std::uint32_t>{};
+    result.reserve(set.size());
+    set.for_each([&result](std::uint32_t elem) { result.push_back(elem); });
+    return result;
+}
+
+/* Ids drawn from [0, range), plus some runs of consecutive ids. */
+auto random_ids(std::size_t n, std::uint32_t range, std::size_t runs, std::mt19937 &gen)
+    -> std::set<std::uint32_t> {
+    auto dist   = std::uniform_int_distribution<std::uint32_t>(0, range - 1);
+    auto result = std::set<std::uint32_t>{};
+    for (std::size_t i = 0; i < n; ++i)
+        result.insert(dist(gen));
+    for (std::size_t i = 0; i < runs; ++i)
+        for (auto x = dist(gen), k = 0u; k < 3000; ++k)
+            result.insert(x + k);
+    return result;
+}
+
+auto to_roaring(const std::set<std::uint32_t> &ids) -> roaring_bitmap {
+    auto result = roaring_bitmap{};
+    for (const auto x : ids)
+        result.insert(x);
+    return result;
+}
+
+auto main() -> int {
+    const auto a = roaring_bitmap{1, 3, 5, 1u << 20, 7u << 16};
+    const auto b = roaring_bitmap{3, 4, 5, 1u << 20};
+    display_set(a & b);
+    display_set(a | b);
+    display_set(a ^ b);
+    display_set(a / b);
+    std::cout << std::boolalpha;
+    std::cout << ((a & b) < a) << ' ' << (a <= b) << ' ';
+    std::cout << (a / b + (a & b) == a) << '\n';
+
+    // every pair of chunk kinds must agree with the std::set algorithms
+    auto gen = std::mt19937{42};
+    auto ok  = true;
+    for (const auto range : {1u << 18, 1u << 22, 1u << 28}) {
+        const auto x = random_ids(40000, range, 8, gen);
+        const auto y = random_ids(20000, range, 8, gen);
+        auto rx      = to_roaring(x);
+        auto ry      = to_roaring(y);
+        for (int round = 0; round < 3; ++round) {
+            auto expect = std::vector<std::uint32_t>{};
+            std::ranges::set_intersection(x, y, std::back_inserter(expect));
+            ok = ok && to_vector(rx & ry) == expect;
+            expect.clear();
+            std::ranges::set_union(x, y, std::back_inserter(expect));
+            ok = ok && to_vector(rx | ry) == expect;
+            expect.clear();
+            std::ranges::set_symmetric_difference(x, y, std::back_inserter(expect));
+            ok = ok && to_vector(rx ^ ry) == expect;
+            expect.clear();
+            std::ranges::set_difference(x, y, std::back_inserter(expect));
+            ok = ok && to_vector(rx / ry) == expect;
+            ok = ok && rx.size() == x.size() && ((rx & ry) <= rx);
+            // runs against the general form, then runs on both sides
+            (round == 0 ? rx : ry).run_optimize();
+        }
+    }
+    std::cout << "agree: " << ok << '\n';
+
+    // std::set pays a tree node of about 40 bytes per id
+    const auto report = [](std::string_view name, const roaring_bitmap &set) {
+        std::cout << name << ": " << set.size() << " ids, "
+                  << static_cast<double>(set.memory_usage()) / set.size()
+                  << " bytes/id vs ~40 for std::set\n";
+    };
+    const auto sparse = random_ids(1 << 18, ~0u, 0, gen);
+    const auto dense  = random_ids(1 << 20, 1 << 21, 0, gen);
+    auto runs         = to_roaring(random_ids(0, 1 << 26, 2000, gen));
+    report("sparse", to_roaring(sparse));
+    report("dense ", to_roaring(dense));
+    report("runs  ", runs);
+    runs.run_optimize();
+    report("runs, optimized", runs);
+
+    const auto other = random_ids(1 << 20, 1 << 21, 0, gen);
+    const auto r0    = to_roaring(dense);
+    const auto r1    = to_roaring(other);
+    const auto tree_and = [&] {
+        auto result = std::set<std::uint32_t>{};
+        std::ranges::set_intersection(dense, other, std::inserter(result, result.end()));
+        return result.size();
+    };
+    const auto tree_or = [&] {
+        auto result = std::set<std::uint32_t>{};
+        std::ranges::set_union(dense, other, std::inserter(result, result.end()));
+        return result.size();
+    };
+    measure<16>("roaring   &", [&] { return (r0 & r1).size(); });
+    measure<16>("std::set  &", tree_and);
+    measure<16>("roaring   |", [&] { return (r0 | r1).size(); });
+    measure<16>("std::set  |", tree_or);
+}
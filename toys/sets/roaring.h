@@ -0,0 +1,544 @@
+#pragma once
+#include "dense.h"
+#include "flat.h"
+#include "sets.h"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
+
+inline namespace set_operation {
+
+namespace __detail {
+
+inline constexpr auto kChunkBits   = std::size_t{1} << 16;
+inline constexpr auto kChunkWords  = kChunkBits / kWordBits;
+inline constexpr auto kArrayLimit  = std::size_t{4096}; // 8 KiB, the size of a bitmap
+inline constexpr auto kBitmapBytes = kChunkWords * sizeof(word_t);
+
+/* The sorted low 16 bits of a sparse chunk. */
+struct array_chunk {
+    std::vector<std::uint16_t> values;
+};
+
+/* One bit per low 16 bits value, with the cardinality kept alongside. */
+struct bitmap_chunk {
+    std::vector<word_t> words = std::vector<word_t>(kChunkWords);
+    std::size_t count         = 0;
+
+    auto test(std::uint16_t x) const -> bool {
+        return (words[x / kWordBits] >> (x % kWordBits) & 1) != 0;
+    }
+
+    auto set(std::uint16_t x) -> void {
+        auto &word = words[x / kWordBits];
+        const auto bit = word_t{1} << (x % kWordBits);
+        count += (word & bit) == 0;
+        word |= bit;
+    }
+
+    auto reset(std::uint16_t x) -> void {
+        auto &word = words[x / kWordBits];
+        const auto bit = word_t{1} << (x % kWordBits);
+        count -= (word & bit) != 0;
+        word &= ~bit;
+    }
+
+    auto flip(std::uint16_t x) -> void {
+        auto &word = words[x / kWordBits];
+        const auto bit = word_t{1} << (x % kWordBits);
+        (word & bit) == 0 ? ++count : --count;
+        word ^= bit;
+    }
+
+    /* Set the closed range [first, last], a word at a time. */
+    auto set_range(std::size_t first, std::size_t last) -> void {
+        const auto lo = first / kWordBits;
+        const auto hi = last / kWordBits;
+        const auto lo_mask = ~word_t{} << (first % kWordBits);
+        const auto hi_mask = ~word_t{} >> (kWordBits - 1 - last % kWordBits);
+        if (lo == hi) {
+            words[lo] |= lo_mask & hi_mask;
+        } else {
+            words[lo] |= lo_mask;
+            std::fill(words.begin() + lo + 1, words.begin() + hi, ~word_t{});
+            words[hi] |= hi_mask;
+        }
+    }
+};
+
+/* Maximal runs of consecutive values, as closed ranges in increasing order. */
+struct run_chunk {
+    struct run {
+        std::uint16_t first;
+        std::uint16_t last;
+
+        friend auto operator==(const run &, const run &) -> bool = default;
+    };
+
+    std::vector<run> runs;
+};
+
+using chunk = std::variant<array_chunk, bitmap_chunk, run_chunk>;
+
+inline auto run_count(const run_chunk &r) -> std::size_t {
+    auto total = std::size_t{};
+    for (const auto [first, last] : r.runs)
+        total += std::size_t{last} - first + 1;
+    return total;
+}
+
+inline auto chunk_count(const chunk &c) -> std::size_t {
+    if (const auto *a = std::get_if<array_chunk>(&c))
+        return a->values.size();
+    if (const auto *b = std::get_if<bitmap_chunk>(&c))
+        return b->count;
+    return run_count(std::get<run_chunk>(c));
+}
+
+inline auto chunk_bytes(const chunk &c) -> std::size_t {
+    if (const auto *a = std::get_if<array_chunk>(&c))
+        return a->values.capacity() * sizeof(std::uint16_t);
+    if (std::holds_alternative<bitmap_chunk>(c))
+        return kBitmapBytes;
+    return std::get<run_chunk>(c).runs.capacity() * sizeof(run_chunk::run);
+}
+
+inline auto chunk_contains(const chunk &c, std::uint16_t x) -> bool {
+    if (const auto *a = std::get_if<array_chunk>(&c))
+        return std::ranges::binary_search(a->values, x);
+    if (const auto *b = std::get_if<bitmap_chunk>(&c))
+        return b->test(x);
+    const auto &runs = std::get<run_chunk>(c).runs;
+    const auto iter  = std::ranges::upper_bound(runs, x, {}, &run_chunk::run::first);
+    return iter != runs.begin() && x <= std::prev(iter)->last;
+}
+
+/* Call fn(low) for each value of the chunk, in increasing order. */
+template <typename _Fn>
+inline auto chunk_for_each(const chunk &c, _Fn &&fn) -> void {
+    if (const auto *a = std::get_if<array_chunk>(&c)) {
+        for (const auto x : a->values)
+            fn(x);
+    } else if (const auto *b = std::get_if<bitmap_chunk>(&c)) {
+        bit_for_each(b->words.data(), kChunkWords, [&fn](std::size_t x) {
+            fn(static_cast<std::uint16_t>(x));
+        });
+    } else {
+        for (const auto [first, last] : std::get<run_chunk>(c).runs)
+            for (auto x = std::size_t{first}; x <= last; ++x)
+                fn(static_cast<std::uint16_t>(x));
+    }
+}
+
+inline auto to_bitmap(const array_chunk &a) -> bitmap_chunk {
+    auto result = bitmap_chunk{};
+    for (const auto x : a.values)
+        result.words[x / kWordBits] |= word_t{1} << (x % kWordBits);
+    result.count = a.values.size();
+    return result;
+}
+
+inline auto to_array(const bitmap_chunk &b) -> array_chunk {
+    auto result = array_chunk{};
+    result.values.reserve(b.count);
+    bit_for_each(b.words.data(), kChunkWords, [&result](std::size_t x) {
+        result.values.push_back(static_cast<std::uint16_t>(x));
+    });
+    return result;
+}
+
+/* The array or bitmap form of a run chunk, whichever is the smaller. */
+inline auto to_general(const run_chunk &r) -> chunk {
+    const auto total = run_count(r);
+    if (total <= kArrayLimit) {
+        auto result = array_chunk{};
+        result.values.reserve(total);
+        for (const auto [first, last] : r.runs)
+            for (auto x = std::size_t{first}; x <= last; ++x)
+                result.values.push_back(static_cast<std::uint16_t>(x));
+        return result;
+    }
+    auto result = bitmap_chunk{};
+    for (const auto [first, last] : r.runs)
+        result.set_range(first, last);
+    result.count = total;
+    return result;
+}
+
+// the array and bitmap forms are canonical: arrays up to kArrayLimit, bitmaps above
+inline auto normalize(array_chunk &&a) -> chunk {
+    if (a.values.size() > kArrayLimit)
+        return to_bitmap(a);
+    return std::move(a);
+}
+
+inline auto normalize(bitmap_chunk &&b) -> chunk {
+    if (b.count <= kArrayLimit)
+        return to_array(b);
+    return std::move(b);
+}
+
+/* Keep the runs only while they are smaller than the general form. */
+inline auto normalize(run_chunk &&r) -> chunk {
+    const auto total = run_count(r);
+    const auto general =
+        total <= kArrayLimit ? total * sizeof(std::uint16_t) : kBitmapBytes;
+    if (r.runs.size() * sizeof(run_chunk::run) < general)
+        return std::move(r);
+    return to_general(r);
+}
+
+/* Collect the runs of any chunk, to decide whether the run form pays off. */
+inline auto to_runs(const chunk &c) -> run_chunk {
+    if (const auto *r = std::get_if<run_chunk>(&c))
+        return *r;
+    auto result = run_chunk{};
+    chunk_for_each(c, [&result](std::uint16_t x) {
+        if (!result.runs.empty() && std::size_t{result.runs.back().last} + 1 == x)
+            result.runs.back().last = x;
+        else
+            result.runs.push_back({x, x});
+    });
+    return result;
+}
+
+inline constexpr auto keeps_left(bit_op op) -> bool {
+    return op != bit_op::bit_and;
+}
+
+inline constexpr auto keeps_right(bit_op op) -> bool {
+    return op == bit_op::bit_or || op == bit_op::bit_xor;
+}
+
+template <bit_op _Op>
+inline auto combine(const array_chunk &a, const array_chunk &b) -> chunk {
+    const auto &x = a.values;
+    const auto &y = b.values;
+    auto result   = array_chunk{};
+    auto &out     = result.values;
+    if constexpr (_Op == bit_op::bit_and) {
+        out.resize(std::min(x.size(), y.size()));
+        const auto *last = intersect(x.data(), x.size(), y.data(), y.size(), out.data());
+        out.resize(static_cast<std::size_t>(last - out.data()));
+    } else if constexpr (_Op == bit_op::bit_or) {
+        out.reserve(x.size() + y.size());
+        std::ranges::set_union(x, y, std::back_inserter(out));
+    } else if constexpr (_Op == bit_op::bit_xor) {
+        out.reserve(x.size() + y.size());
+        std::ranges::set_symmetric_difference(x, y, std::back_inserter(out));
+    } else {
+        out.reserve(x.size());
+        std::ranges::set_difference(x, y, std::back_inserter(out));
+    }
+    return normalize(std::move(result));
+}
+
+template <bit_op _Op>
+inline auto combine(const bitmap_chunk &a, const bitmap_chunk &b) -> chunk {
+    auto result = bitmap_chunk{};
+    bit_apply<_Op>(result.words.data(), a.words.data(), b.words.data(), kChunkWords);
+    result.count = bit_count(result.words.data(), kChunkWords);
+    return normalize(std::move(result));
+}
+
+template <bit_op _Op>
+inline auto combine(const array_chunk &a, const bitmap_chunk &b) -> chunk {
+    if constexpr (_Op == bit_op::bit_and || _Op == bit_op::bit_andnot) {
+        // probe the bitmap for each value, the result can only shrink
+        constexpr auto keep = _Op == bit_op::bit_and;
+        auto result         = array_chunk{};
+        result.values.reserve(a.values.size());
+        for (const auto x : a.values)
+            if (b.test(x) == keep)
+                result.values.push_back(x);
+        return result;
+    } else {
+        auto result = b;
+        for (const auto x : a.values)
+            _Op == bit_op::bit_or ? result.set(x) : result.flip(x);
+        return normalize(std::move(result));
+    }
+}
+
+template <bit_op _Op>
+inline auto combine(const bitmap_chunk &a, const array_chunk &b) -> chunk {
+    if constexpr (_Op != bit_op::bit_andnot) {
+        return combine<_Op>(b, a);
+    } else {
+        auto result = a;
+        for (const auto x : b.values)
+            result.reset(x);
+        return normalize(std::move(result));
+    }
+}
+
+/* Runs against the general form: expand the runs and use the kernels above. */
+template <bit_op _Op, typename _Lhs, typename _Rhs>
+    requires(std::same_as<_Lhs, run_chunk> != std::same_as<_Rhs, run_chunk>)
+inline auto combine(const _Lhs &a, const _Rhs &b) -> chunk {
+    if constexpr (std::same_as<_Lhs, run_chunk>) {
+        const auto lhs = to_general(a);
+        return std::visit([&b](const auto &x) { return combine<_Op>(x, b); }, lhs);
+    } else {
+        const auto rhs = to_general(b);
+        return std::visit([&a](const auto &y) { return combine<_Op>(a, y); }, rhs);
+    }
+}
+
+/* Intersections and unions of runs stay runs, and are computed on the ranges alone. */
+template <bit_op _Op>
+inline auto combine(const run_chunk &a, const run_chunk &b) -> chunk {
+    if constexpr (_Op == bit_op::bit_and) {
+        auto result = run_chunk{};
+        auto i      = a.runs.begin();
+        auto j      = b.runs.begin();
+        while (i != a.runs.end() && j != b.runs.end()) {
+            const auto first = std::max(i->first, j->first);
+            const auto last  = std::min(i->last, j->last);
+            if (first <= last)
+                result.runs.push_back({first, last});
+            (i->last < j->last ? i : j)++;
+        }
+        return normalize(std::move(result));
+    } else if constexpr (_Op == bit_op::bit_or) {
+        auto result = run_chunk{};
+        auto &runs  = result.runs;
+        runs.reserve(a.runs.size() + b.runs.size());
+        const auto first = &run_chunk::run::first;
+        std::ranges::merge(a.runs, b.runs, std::back_inserter(runs), {}, first, first);
+        // coalesce overlapping and adjacent runs in place
+        auto out = runs.begin();
+        for (auto iter = runs.begin(); iter != runs.end(); ++iter) {
+            auto *back = out == runs.begin() ? nullptr : std::to_address(std::prev(out));
+            if (back != nullptr && iter->first <= std::size_t{back->last} + 1)
+                back->last = std::max(back->last, iter->last);
+            else
+                *out++ = *iter;
+        }
+        runs.erase(out, runs.end());
+        return normalize(std::move(result));
+    } else {
+        return std::visit(
+            [](const auto &x, const auto &y) { return combine<_Op>(x, y); },
+            to_general(a), to_general(b)
+        );
+    }
+}
+
+inline auto chunk_equal(const chunk &a, const chunk &b) -> bool {
+    if (a.index() == b.index()) {
+        if (const auto *x = std::get_if<array_chunk>(&a))
+            return x->values == std::get<array_chunk>(b).values;
+        if (const auto *x = std::get_if<bitmap_chunk>(&a))
+            return x->words == std::get<bitmap_chunk>(b).words;
+        return std::get<run_chunk>(a).runs == std::get<run_chunk>(b).runs;
+    }
+    // runs against the general form, which is rare: compare the runs of both
+    return chunk_count(a) == chunk_count(b) && to_runs(a).runs == to_runs(b).runs;
+}
+
+} // namespace __detail
+
+/**
+ * A compressed set of 32-bit ids, in the style of roaring bitmaps.
+ * Ids are grouped in chunks by their high 16 bits. A chunk holds its low 16 bits
+ * as a sorted array while sparse, as a 8 KiB bitmap while dense, and as runs after
+ * run_optimize() when those are smaller. Each pair of chunk kinds has its own kernel.
+ * The comparison and the disjoint + and - come from set_op_traits.
+ */
+struct roaring_bitmap {
+public:
+    using value_type = std::uint32_t;
+
+    roaring_bitmap() = default;
+
+    roaring_bitmap(std::initializer_list<std::uint32_t> list) {
+        for (const auto x : list)
+            insert(x);
+    }
+
+    auto contains(std::uint32_t x) const -> bool {
+        const auto k = _M_find(_S_high(x));
+        return k != _M_keys.size() && _M_keys[k] == _S_high(x) &&
+               __detail::chunk_contains(_M_chunks[k], _S_low(x));
+    }
+
+    auto insert(std::uint32_t x) -> bool {
+        using namespace __detail;
+        const auto k = _M_find(_S_high(x));
+        if (k == _M_keys.size() || _M_keys[k] != _S_high(x)) {
+            _M_keys.insert(_M_keys.begin() + k, _S_high(x));
+            _M_chunks.insert(_M_chunks.begin() + k, array_chunk{{_S_low(x)}});
+            return true;
+        }
+        auto &c = _M_chunks[k];
+        if (chunk_contains(c, _S_low(x)))
+            return false;
+        if (const auto *r = std::get_if<run_chunk>(&c))
+            c = to_general(*r);
+        if (auto *a = std::get_if<array_chunk>(&c)) {
+            a->values.insert(std::ranges::lower_bound(a->values, _S_low(x)), _S_low(x));
+            if (a->values.size() > kArrayLimit)
+                c = to_bitmap(*a);
+        } else {
+            std::get<bitmap_chunk>(c).set(_S_low(x));
+        }
+        return true;
+    }
+
+    auto erase(std::uint32_t x) -> bool {
+        using namespace __detail;
+        const auto k = _M_find(_S_high(x));
+        if (k == _M_keys.size() || _M_keys[k] != _S_high(x))
+            return false;
+        auto &c = _M_chunks[k];
+        if (!chunk_contains(c, _S_low(x)))
+            return false;
+        if (const auto *r = std::get_if<run_chunk>(&c))
+            c = to_general(*r);
+        if (auto *a = std::get_if<array_chunk>(&c)) {
+            a->values.erase(std::ranges::lower_bound(a->values, _S_low(x)));
+        } else {
+            auto &b = std::get<bitmap_chunk>(c);
+            b.reset(_S_low(x));
+            if (b.count <= kArrayLimit)
+                c = to_array(b);
+        }
+        if (chunk_count(c) == 0) {
+            _M_keys.erase(_M_keys.begin() + k);
+            _M_chunks.erase(_M_chunks.begin() + k);
+        }
+        return true;
+    }
+
+    auto size() const -> std::size_t {
+        auto total = std::size_t{};
+        for (const auto &c : _M_chunks)
+            total += __detail::chunk_count(c);
+        return total;
+    }
+
+    auto empty() const -> bool {
+        return _M_keys.empty();
+    }
+
+    /* Call fn(id) for each id, in increasing order. */
+    template <typename _Fn>
+    auto for_each(_Fn &&fn) const -> void {
+        for (std::size_t k = 0; k < _M_keys.size(); ++k) {
+            const auto high = std::uint32_t{_M_keys[k]} << 16;
+            __detail::chunk_for_each(_M_chunks[k], [&](std::uint16_t low) {
+                fn(high | low);
+            });
+        }
+    }
+
+    /* Turn the chunks that are mostly consecutive ids into runs. */
+    auto run_optimize() -> void {
+        for (auto &c : _M_chunks)
+            c = __detail::normalize(__detail::to_runs(c));
+    }
+
+    /* Bytes held by the set, including the chunk storage. */
+    auto memory_usage() const -> std::size_t {
+        auto total = sizeof(*this) + _M_keys.capacity() * sizeof(std::uint16_t) +
+                     _M_chunks.capacity() * sizeof(__detail::chunk);
+        for (const auto &c : _M_chunks)
+            total += __detail::chunk_bytes(c);
+        return total;
+    }
+
+    friend auto operator&(const roaring_bitmap &a, const roaring_bitmap &b)
+        -> roaring_bitmap {
+        return _S_combine<__detail::bit_op::bit_and>(a, b);
+    }
+
+    friend auto operator|(const roaring_bitmap &a, const roaring_bitmap &b)
+        -> roaring_bitmap {
+        return _S_combine<__detail::bit_op::bit_or>(a, b);
+    }
+
+    friend auto operator^(const roaring_bitmap &a, const roaring_bitmap &b)
+        -> roaring_bitmap {
+        return _S_combine<__detail::bit_op::bit_xor>(a, b);
+    }
+
+    friend auto operator/(const roaring_bitmap &a, const roaring_bitmap &b)
+        -> roaring_bitmap {
+        return _S_combine<__detail::bit_op::bit_andnot>(a, b);
+    }
+
+    friend auto operator==(const roaring_bitmap &a, const roaring_bitmap &b) -> bool {
+        return a._M_keys == b._M_keys &&
+               std::ranges::equal(a._M_chunks, b._M_chunks, __detail::chunk_equal);
+    }
+
+private:
+    static auto _S_high(std::uint32_t x) -> std::uint16_t {
+        return static_cast<std::uint16_t>(x >> 16);
+    }
+
+    static auto _S_low(std::uint32_t x) -> std::uint16_t {
+        return static_cast<std::uint16_t>(x);
+    }
+
+    auto _M_find(std::uint16_t high) const -> std::size_t {
+        const auto iter = std::ranges::lower_bound(_M_keys, high);
+        return static_cast<std::size_t>(iter - _M_keys.begin());
+    }
+
+    auto _M_push(std::uint16_t high, __detail::chunk c) -> void {
+        _M_keys.push_back(high);
+        _M_chunks.push_back(std::move(c));
+    }
+
+    /* Merge the chunk keys, and combine the chunks present on both sides. */
+    template <__detail::bit_op _Op>
+    static auto _S_combine(const roaring_bitmap &a, const roaring_bitmap &b)
+        -> roaring_bitmap {
+        using namespace __detail;
+        const auto m = a._M_keys.size();
+        const auto n = b._M_keys.size();
+        auto result  = roaring_bitmap{};
+        result._M_keys.reserve(keeps_right(_Op) ? m + n : m);
+        result._M_chunks.reserve(keeps_right(_Op) ? m + n : m);
+        auto i = std::size_t{};
+        auto j = std::size_t{};
+        while (i != m || j != n) {
+            if (j == n || (i != m && a._M_keys[i] < b._M_keys[j])) {
+                if constexpr (keeps_left(_Op))
+                    result._M_push(a._M_keys[i], a._M_chunks[i]);
+                ++i;
+            } else if (i == m || b._M_keys[j] < a._M_keys[i]) {
+                if constexpr (keeps_right(_Op))
+                    result._M_push(b._M_keys[j], b._M_chunks[j]);
+                ++j;
+            } else {
+                auto c = std::visit(
+                    [](const auto &x, const auto &y) { return combine<_Op>(x, y); },
+                    a._M_chunks[i], b._M_chunks[j]
+                );
+                if (chunk_count(c) != 0)
+                    result._M_push(a._M_keys[i], std::move(c));
+                ++i;
+                ++j;
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::uint16_t> _M_keys; // sorted high 16 bits
+    std::vector<__detail::chunk> _M_chunks;
+};
+
+template <>
+struct set_op_traits<roaring_bitmap> : std::true_type {};
+
+} // namespace set_operation
@@ -25,7 +25,9 @@ inline constexpr auto operator&(key_set x, key_set y) -> key_set {
 }
 
 template <>
-struct set_op_traits<key_set> : std::true_type {};
+struct set_op_traits<key_set> : std::true_type {
+    static constexpr auto costs = set_costs::uniform(set_cost::constant);
+};
 
 namespace std {
 
@@ -66,6 +68,16 @@ auto display_set(const std::set<int> &set) -> void {
 template <typename _Tp>
 struct set_op_traits<std::set<_Tp>> : std::true_type {};
 
+// | and / are now streamed as one merge, instead of built from & and ^
+template <typename _Tp>
+struct sorted_set_traits<std::set<_Tp>> : std::true_type {
+    static auto from_sorted(std::vector<_Tp> &&values) -> std::set<_Tp> {
+        return std::set<_Tp>{
+            std::make_move_iterator(values.begin()), std::make_move_iterator(values.end())
+        };
+    }
+};
+
 struct custom_set : private std::set<int> {
     using std::set<int>::set;
     using std::set<int>::begin;
@@ -109,6 +121,18 @@ auto main() -> int {
     display_set(set0 / set1);
     display_set(set1 / set0);
 
+    // one pass over all four sets, instead of three temporary sets
+    const auto set4 = std::set<int>{1, 4, 5};
+    const auto set5 = std::set<int>{3, 5, 6};
+    display_set((lazy(set0) & set1) | (lazy(set4) / set5));
+    display_set(evaluate((lazy(set0) ^ set1) & (lazy(set4) | set5)));
+
+    // erases from and inserts into set6 in place, without a temporary set
+    auto set6 = set4;
+    set6 |= set5;
+    set6 /= set1;
+    display_set(set6);
+
     auto set2 = custom_set{1, 2};
     auto set3 = custom_set{2, 3};
     display_set(set2 & set3);
@@ -121,4 +145,11 @@ auto main() -> int {
     std::cout << (set2 >= set3) << std::endl;
     std::cout << ((set2 & set3) < set3) << std::endl;
     std::cout << ((set2 / set3) > set2) << std::endl;
+
+    // custom_set can't fuse, so the expression runs one operation at a time
+    display_set(evaluate((lazy(set2) ^ set3) | set2));
+
+    // custom_set declares no compound assignments, so this is set2 = set2 & set3
+    set2 &= set3;
+    display_set(set2);
 }
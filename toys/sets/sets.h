@@ -1,8 +1,19 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <compare>
 #include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <ranges>
 #include <stdexcept>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 inline namespace set_operation {
 
@@ -12,6 +23,387 @@ struct set_op_traits : std::false_type {};
 template <typename _Tp>
 concept set_like = set_op_traits<_Tp>::value;
 
+/* Asymptotic cost classes of the primitive operations, as relative weights. */
+enum class set_cost : std::size_t {
+    constant = 1,       // O(1), such as flags in one word
+    linear   = 1 << 10, // O(n) in the elements held
+    universe = 1 << 20, // O(universe), such as ~ on a sorted vector
+};
+
+/**
+ * The costs which a set_op_traits specialization may declare as
+ * static constexpr auto costs = set_costs{...}. They pick the cheapest
+ * derivation of each missing operation. Undeclared costs count as linear.
+ */
+struct set_costs {
+    set_cost op_and = set_cost::linear;
+    set_cost op_or  = set_cost::linear;
+    set_cost op_xor = set_cost::linear;
+    set_cost op_sub = set_cost::linear;
+    set_cost op_not = set_cost::linear;
+    set_cost op_eq  = set_cost::linear;
+
+    static constexpr auto uniform(set_cost cost) -> set_costs {
+        return {cost, cost, cost, cost, cost, cost};
+    }
+};
+
+/**
+ * The compound assignments which a type defines itself, declared by its
+ * set_op_traits as static constexpr auto in_place = set_in_place{...}.
+ * The others are generated: sorted sets of nodes erase and insert in place,
+ * and any other set assigns a = std::move(a) op b.
+ */
+struct set_in_place {
+    bool op_and = false;
+    bool op_or  = false;
+    bool op_xor = false;
+    bool op_sub = false;
+};
+
+/**
+ * Opt in to streaming evaluation: the set iterates its elements in increasing
+ * order, and the specialization provides from_sorted(std::vector<value_type> &&),
+ * which builds the set from a sorted vector without duplicates.
+ * It may also provide intersect(a, m, b, n, out) -> end of out, over arrays,
+ * which may write up to kSetSlack elements past the end of the result.
+ */
+template <typename _Tp>
+struct sorted_set_traits : std::false_type {};
+
+/**
+ * Opt in to word-wise evaluation: data() exposes a fixed number of words, given by the
+ * specialization's words member.
+ */
+template <typename _Tp>
+struct word_set_traits : std::false_type {};
+
+template <typename _Tp>
+concept sorted_set_like =
+    set_like<_Tp> && sorted_set_traits<_Tp>::value &&
+    std::ranges::forward_range<const _Tp> && std::ranges::sized_range<const _Tp> &&
+    std::is_lvalue_reference_v<std::ranges::range_reference_t<const _Tp>>;
+
+template <typename _Tp>
+concept word_set_like = set_like<_Tp> && word_set_traits<_Tp>::value &&
+                        std::constructible_from<_Tp> && requires(_Tp &a) { *a.data(); };
+
+// sets which evaluate a whole expression in one pass over the operands
+template <typename _Tp>
+concept fused_set_like = sorted_set_like<_Tp> || word_set_like<_Tp>;
+
+namespace __detail {
+
+enum class set_expr_op { op_and, op_or, op_xor, op_sub };
+
+template <typename _Tp>
+struct set_leaf;
+
+template <set_expr_op _Op, typename _Lhs, typename _Rhs>
+struct set_node;
+
+template <typename _Tp>
+struct is_set_expression : std::false_type {};
+
+template <typename _Tp>
+struct is_set_expression<set_leaf<_Tp>> : std::true_type {};
+
+template <set_expr_op _Op, typename _Lhs, typename _Rhs>
+struct is_set_expression<set_node<_Op, _Lhs, _Rhs>> : std::true_type {};
+
+template <typename _Expr>
+auto evaluate_expr(const _Expr &expr) -> typename _Expr::set_type;
+
+// elements per leaf and per round when streaming sorted sets, small enough for L1
+inline constexpr auto kSetBlock = std::size_t{1024};
+inline constexpr auto kSetSlack = std::size_t{16}; // for kernels storing whole vectors
+
+// whether blocks of _Range can go to the intersect kernel of the set, if any
+template <typename _Set, typename _Range>
+concept set_intersect_kernel =
+    std::ranges::contiguous_range<_Range> &&
+    requires(const std::ranges::range_value_t<_Range> *a) {
+        { sorted_set_traits<_Set>::intersect(a, 0, a, 0, nullptr) };
+    };
+
+/* A reference to an operand. It must outlive the expression. */
+template <typename _Tp>
+struct set_leaf {
+    using set_type = _Tp;
+    using _Value   = std::ranges::range_value_t<const _Tp>;
+
+    static constexpr auto leaves  = std::size_t{1};
+    static constexpr auto scratch = std::size_t{0};
+
+    /* The position of the leaf, while streaming the expression in blocks. */
+    struct stream {
+        std::ranges::iterator_t<const _Tp> iter;
+        std::ranges::sentinel_t<const _Tp> last;
+
+        auto done() const -> bool {
+            return iter == last;
+        }
+
+        // lower the pivot to the first element after the next block of this leaf
+        auto bound(const _Value *&pivot) const -> void {
+            const auto stop = std::ranges::next(iter, kSetBlock, last);
+            if (stop != last && (pivot == nullptr || *stop < *pivot))
+                pivot = std::addressof(*stop);
+        }
+
+        /* Pass the elements below pivot (all for nullptr) to fn, and skip them. */
+        template <typename _Fn>
+        auto block(const _Value *pivot, _Fn &&fn) -> void {
+            auto stop = last;
+            if (pivot != nullptr) {
+                const auto limit = std::ranges::next(iter, kSetBlock, last);
+                stop = std::ranges::lower_bound(iter, limit, *pivot);
+            }
+            fn(std::ranges::subrange(iter, stop));
+            iter = stop;
+        }
+    };
+
+    const _Tp &set;
+
+    auto size_bound() const -> std::size_t {
+        return static_cast<std::size_t>(std::ranges::size(set));
+    }
+
+    auto make_stream(_Value *&) const -> stream {
+        return {std::ranges::begin(set), std::ranges::end(set)};
+    }
+
+    auto word(std::size_t i) const {
+        return set.data()[i];
+    }
+
+    auto eager() const -> const _Tp & {
+        return set;
+    }
+};
+
+template <set_expr_op _Op, typename _Lhs, typename _Rhs>
+struct set_node {
+    using set_type = typename _Lhs::set_type;
+    using _Value   = std::ranges::range_value_t<const set_type>;
+
+    static constexpr auto leaves = _Lhs::leaves + _Rhs::leaves;
+    // a block of this node holds at most kSetBlock elements of each leaf
+    static constexpr auto kBuffer = leaves * kSetBlock + kSetSlack;
+    static constexpr auto scratch = _Lhs::scratch + _Rhs::scratch + kBuffer;
+
+    /* Merges a block of both children into its own scratch buffer. */
+    struct stream {
+        typename _Lhs::stream lhs;
+        typename _Rhs::stream rhs;
+        _Value *buffer;
+
+        auto done() const -> bool {
+            return lhs.done() && rhs.done();
+        }
+
+        auto bound(const _Value *&pivot) const -> void {
+            lhs.bound(pivot);
+            rhs.bound(pivot);
+        }
+
+        template <typename _Fn>
+        auto block(const _Value *pivot, _Fn &&fn) -> void {
+            auto *last = buffer;
+            lhs.block(pivot, [&](auto &&a) {
+                rhs.block(pivot, [&](auto &&b) { last = _S_merge(a, b, buffer); });
+            });
+            fn(std::ranges::subrange(buffer, last));
+        }
+    };
+
+    _Lhs lhs;
+    _Rhs rhs;
+
+    /* An upper bound of the result size, so that the output allocates once. */
+    auto size_bound() const -> std::size_t {
+        const auto a = lhs.size_bound();
+        const auto b = rhs.size_bound();
+        if constexpr (_Op == set_expr_op::op_and)
+            return a < b ? a : b;
+        else if constexpr (_Op == set_expr_op::op_sub)
+            return a;
+        else
+            return a + b;
+    }
+
+    /* Carve the scratch buffers of the whole tree out of one allocation. */
+    auto make_stream(_Value *&scratch) const -> stream {
+        auto result = stream{lhs.make_stream(scratch), rhs.make_stream(scratch), scratch};
+        scratch += kBuffer;
+        return result;
+    }
+
+    auto word(std::size_t i) const {
+        const auto a = lhs.word(i);
+        const auto b = rhs.word(i);
+        if constexpr (_Op == set_expr_op::op_and)
+            return a & b;
+        else if constexpr (_Op == set_expr_op::op_or)
+            return a | b;
+        else if constexpr (_Op == set_expr_op::op_xor)
+            return a ^ b;
+        else
+            return a & ~b;
+    }
+
+    /* Evaluate node by node with the set's own operators, for sets which can't fuse. */
+    auto eager() const -> set_type {
+        if constexpr (_Op == set_expr_op::op_and)
+            return lhs.eager() & rhs.eager();
+        else if constexpr (_Op == set_expr_op::op_or)
+            return lhs.eager() | rhs.eager();
+        else if constexpr (_Op == set_expr_op::op_xor)
+            return lhs.eager() ^ rhs.eager();
+        else
+            return lhs.eager() / rhs.eager();
+    }
+
+    operator set_type() const {
+        return evaluate_expr(*this);
+    }
+
+private:
+    template <typename _Range0, typename _Range1>
+    static auto _S_merge(const _Range0 &a, const _Range1 &b, _Value *out) -> _Value * {
+        using _Traits = sorted_set_traits<set_type>;
+        if constexpr (
+            _Op == set_expr_op::op_and && set_intersect_kernel<set_type, _Range0> &&
+            set_intersect_kernel<set_type, _Range1>
+        )
+            return _Traits::intersect(
+                std::ranges::data(a), std::ranges::size(a), std::ranges::data(b),
+                std::ranges::size(b), out
+            );
+        else if constexpr (_Op == set_expr_op::op_and)
+            return std::ranges::set_intersection(a, b, out).out;
+        else if constexpr (_Op == set_expr_op::op_or)
+            return std::ranges::set_union(a, b, out).out;
+        else if constexpr (_Op == set_expr_op::op_xor)
+            return std::ranges::set_symmetric_difference(a, b, out).out;
+        else
+            return std::ranges::set_difference(a, b, out).out;
+    }
+};
+
+/**
+ * Stream the whole tree in rounds. Each round takes the elements below a pivot,
+ * at most kSetBlock from each leaf, and merges them node by node in scratch
+ * buffers which stay in cache. Only the result and the scratch are allocated.
+ */
+template <typename _Expr>
+inline auto evaluate_sorted(const _Expr &expr) -> typename _Expr::set_type {
+    using _Tp    = typename _Expr::set_type;
+    using _Value = std::ranges::range_value_t<const _Tp>;
+
+    auto scratch = std::vector<_Value>(_Expr::scratch);
+    auto *next   = scratch.data();
+    auto stream  = expr.make_stream(next);
+    auto result  = std::vector<_Value>{};
+    result.reserve(expr.size_bound());
+    while (!stream.done()) {
+        const _Value *pivot = nullptr;
+        stream.bound(pivot);
+        stream.block(pivot, [&result](auto &&range) {
+            result.insert(result.end(), range.begin(), range.end());
+        });
+    }
+    return sorted_set_traits<_Tp>::from_sorted(std::move(result));
+}
+
+template <typename _Expr>
+inline auto evaluate_expr(const _Expr &expr) -> typename _Expr::set_type {
+    using _Tp = typename _Expr::set_type;
+    if constexpr (word_set_like<_Tp>) {
+        auto result = _Tp{};
+        auto *words = result.data();
+        for (std::size_t i = 0; i < word_set_traits<_Tp>::words; ++i)
+            words[i] = expr.word(i);
+        return result;
+    } else if constexpr (sorted_set_like<_Tp>) {
+        return evaluate_sorted(expr);
+    } else {
+        return expr.eager();
+    }
+}
+
+template <typename _Tp>
+using set_expr_t = std::conditional_t<
+    is_set_expression<std::remove_cvref_t<_Tp>>::value, std::remove_cvref_t<_Tp>,
+    set_leaf<std::remove_cvref_t<_Tp>>>;
+
+// a set operand is held by reference, so it must not be a temporary
+template <typename _Tp>
+concept set_expr_operand =
+    is_set_expression<std::remove_cvref_t<_Tp>>::value ||
+    (set_like<std::remove_cvref_t<_Tp>> && std::is_lvalue_reference_v<_Tp>);
+
+template <typename _Lhs, typename _Rhs>
+concept set_expr_pair =
+    set_expr_operand<_Lhs> && set_expr_operand<_Rhs> &&
+    (is_set_expression<std::remove_cvref_t<_Lhs>>::value ||
+     is_set_expression<std::remove_cvref_t<_Rhs>>::value) &&
+    std::same_as<
+        typename set_expr_t<_Lhs>::set_type, typename set_expr_t<_Rhs>::set_type>;
+
+template <set_expr_op _Op, typename _Lhs, typename _Rhs>
+inline auto make_set_node(const _Lhs &a, const _Rhs &b)
+    -> set_node<_Op, set_expr_t<_Lhs>, set_expr_t<_Rhs>> {
+    return {set_expr_t<_Lhs>{a}, set_expr_t<_Rhs>{b}};
+}
+
+} // namespace __detail
+
+template <typename _Tp>
+concept set_expression = __detail::is_set_expression<std::remove_cvref_t<_Tp>>::value;
+
+/**
+ * Start a lazy expression: &, |, ^ and / on it build nodes instead of sets.
+ * Converting the expression to the set type, or evaluate(), runs it in one pass
+ * for fused_set_like sets, with a single allocation for the result.
+ * Other sets fall back to one operation at a time.
+ * The operands are held by reference, so evaluate within the full expression.
+ */
+template <set_like _Tp>
+inline auto lazy(const _Tp &set) -> __detail::set_leaf<_Tp> {
+    return {set};
+}
+
+template <set_expression _Expr>
+inline auto evaluate(const _Expr &expr) -> typename _Expr::set_type {
+    return __detail::evaluate_expr(expr);
+}
+
+template <typename _Lhs, typename _Rhs>
+    requires(__detail::set_expr_pair<_Lhs, _Rhs>)
+inline auto operator&(_Lhs &&a, _Rhs &&b) {
+    return __detail::make_set_node<__detail::set_expr_op::op_and>(a, b);
+}
+
+template <typename _Lhs, typename _Rhs>
+    requires(__detail::set_expr_pair<_Lhs, _Rhs>)
+inline auto operator|(_Lhs &&a, _Rhs &&b) {
+    return __detail::make_set_node<__detail::set_expr_op::op_or>(a, b);
+}
+
+template <typename _Lhs, typename _Rhs>
+    requires(__detail::set_expr_pair<_Lhs, _Rhs>)
+inline auto operator^(_Lhs &&a, _Rhs &&b) {
+    return __detail::make_set_node<__detail::set_expr_op::op_xor>(a, b);
+}
+
+template <typename _Lhs, typename _Rhs>
+    requires(__detail::set_expr_pair<_Lhs, _Rhs>)
+inline auto operator/(_Lhs &&a, _Rhs &&b) {
+    return __detail::make_set_node<__detail::set_expr_op::op_sub>(a, b);
+}
+
 namespace __detail {
 
 template <typename _Tp>
@@ -47,6 +439,84 @@ concept set_has_default_not = requires(const _Tp &a) {
 template <typename _Tp>
 concept set_has_default_eq = std::equality_comparable<_Tp>;
 
+/* Whether a <= b and b <= a, in one pass over both and without building any set. */
+template <fused_set_like _Tp>
+inline auto fused_subsets(const _Tp &a, const _Tp &b) -> std::pair<bool, bool> {
+    auto le = true;
+    auto ge = true;
+    if constexpr (word_set_like<_Tp>) {
+        for (std::size_t i = 0; i < word_set_traits<_Tp>::words && (le || ge); ++i) {
+            le = le && (a.data()[i] & ~b.data()[i]) == 0;
+            ge = ge && (b.data()[i] & ~a.data()[i]) == 0;
+        }
+    } else {
+        auto x = std::ranges::begin(a);
+        auto y = std::ranges::begin(b);
+        while (x != std::ranges::end(a) && y != std::ranges::end(b) && (le || ge)) {
+            if (*x < *y) {
+                le = false;
+                ++x;
+            } else if (*y < *x) {
+                ge = false;
+                ++y;
+            } else {
+                ++x;
+                ++y;
+            }
+        }
+        le = le && x == std::ranges::end(a);
+        ge = ge && y == std::ranges::end(b);
+    }
+    return {le, ge};
+}
+
+template <typename _Tp>
+inline constexpr auto set_costs_of() -> set_costs {
+    if constexpr (requires { set_op_traits<_Tp>::costs; })
+        return set_op_traits<_Tp>::costs;
+    else
+        return {};
+}
+
+template <typename _Tp>
+inline constexpr auto set_in_place_of() -> set_in_place {
+    if constexpr (requires { set_op_traits<_Tp>::in_place; })
+        return set_op_traits<_Tp>::in_place;
+    else
+        return {};
+}
+
+inline constexpr auto kNoPlan = ~std::size_t{};
+
+using set_plan_use = std::tuple<bool, set_cost, int>;
+
+/* The total weight of a formula, given (available, cost, uses) for each primitive. */
+inline constexpr auto plan_cost(std::initializer_list<set_plan_use> uses) -> std::size_t {
+    auto total = std::size_t{};
+    for (const auto &[has, cost, count] : uses) {
+        if (!has)
+            return kNoPlan;
+        total += static_cast<std::size_t>(cost) * static_cast<std::size_t>(count);
+    }
+    return total;
+}
+
+/* The index of the cheapest available formula, earlier ones winning ties. */
+template <std::size_t _Nm>
+inline constexpr auto cheapest_plan(const std::array<std::size_t, _Nm> &costs)
+    -> std::size_t {
+    auto best = kNoPlan;
+    for (std::size_t i = 0; i < _Nm; ++i)
+        if (costs[i] != kNoPlan && (best == kNoPlan || costs[i] < costs[best]))
+            best = i;
+    return best;
+}
+
+/**
+ * Derives the missing operations from the available ones. Each operation lists
+ * its formulas, and the cheapest one under the declared set_costs is chosen at
+ * compile time. The plan_* members are the chosen indices into formulas_*.
+ */
 template <set_like _Tp>
 struct set_op_impl : set_op_traits<_Tp> {
 private:
@@ -59,95 +529,172 @@ private:
     static constexpr auto has_not = set_has_default_not<_Tp>;
     static constexpr auto has_eq  = set_has_default_eq<_Tp>;
 
+    // fused sets derive any operation in one pass, instead of from the others
+    static constexpr auto fused = fused_set_like<_Tp>;
+
+    static constexpr auto kCost = set_costs_of<_Tp>();
+
+    // one pass over the words of the universe, or over the elements
+    static constexpr auto kFused =
+        word_set_like<_Tp> ? set_cost::universe : set_cost::linear;
+
+    static constexpr auto kEmpty = std::constructible_from<_Tp>;
+
+    template <set_expr_op _Op>
+    static auto _S_fused(const _Tp &a, const _Tp &b) -> _Tp {
+        return evaluate_expr(make_set_node<_Op>(a, b));
+    }
+
 public:
+    static constexpr auto formulas_and = std::array<std::string_view, 5>{
+        "a & b", "fused", "a / (a / b)", "(a | b) ^ (a ^ b)", "~(~a | ~b)"
+    };
+
+    static constexpr auto plan_and = cheapest_plan(std::array{
+        plan_cost({{has_and, kCost.op_and, 1}}),
+        plan_cost({{fused, kFused, 1}}),
+        plan_cost({{has_sub, kCost.op_sub, 2}}),
+        plan_cost({{has_or, kCost.op_or, 1}, {has_xor, kCost.op_xor, 2}}),
+        plan_cost({{has_or, kCost.op_or, 1}, {has_not, kCost.op_not, 3}}),
+    });
+
+    static constexpr auto formulas_or = std::array<std::string_view, 6>{
+        "a | b", "fused", "(a / b) ^ b", "(a & b) ^ (a ^ b)", "~(~a / b)", "~(~a & ~b)"
+    };
+
+    static constexpr auto plan_or = cheapest_plan(std::array{
+        plan_cost({{has_or, kCost.op_or, 1}}),
+        plan_cost({{fused, kFused, 1}}),
+        plan_cost({{has_sub, kCost.op_sub, 1}, {has_xor, kCost.op_xor, 1}}),
+        plan_cost({{has_and, kCost.op_and, 1}, {has_xor, kCost.op_xor, 2}}),
+        plan_cost({{has_sub, kCost.op_sub, 1}, {has_not, kCost.op_not, 2}}),
+        plan_cost({{has_and, kCost.op_and, 1}, {has_not, kCost.op_not, 3}}),
+    });
+
+    static constexpr auto formulas_xor = std::array<std::string_view, 6>{
+        "a ^ b", "fused", "(a / b) | (b / a)", "~(~b / a) / (a / ~b)",
+        "~(a | ~b) | ~(~a | b)", "~(a & b) & ~(~a & ~b)"
+    };
+
+    static constexpr auto plan_xor = cheapest_plan(std::array{
+        plan_cost({{has_xor, kCost.op_xor, 1}}),
+        plan_cost({{fused, kFused, 1}}),
+        plan_cost({{has_sub, kCost.op_sub, 2}, {has_or, kCost.op_or, 1}}),
+        plan_cost({{has_not, kCost.op_not, 2}, {has_sub, kCost.op_sub, 3}}),
+        plan_cost({{has_not, kCost.op_not, 4}, {has_or, kCost.op_or, 3}}),
+        plan_cost({{has_not, kCost.op_not, 4}, {has_and, kCost.op_and, 3}}),
+    });
+
+    static constexpr auto formulas_sub = std::array<std::string_view, 6>{
+        "a / b", "fused", "(a & b) ^ a", "(a | b) ^ b", "a & ~b", "~(~a | b)"
+    };
+
+    static constexpr auto plan_sub = cheapest_plan(std::array{
+        plan_cost({{has_sub, kCost.op_sub, 1}}),
+        plan_cost({{fused, kFused, 1}}),
+        plan_cost({{has_and, kCost.op_and, 1}, {has_xor, kCost.op_xor, 1}}),
+        plan_cost({{has_or, kCost.op_or, 1}, {has_xor, kCost.op_xor, 1}}),
+        plan_cost({{has_and, kCost.op_and, 1}, {has_not, kCost.op_not, 1}}),
+        plan_cost({{has_or, kCost.op_or, 1}, {has_not, kCost.op_not, 2}}),
+    });
+
+    static constexpr auto formulas_cmp = std::array<std::string_view, 5>{
+        "a <=> b", "fused", "a & b == a, b", "a | b == a, b", "a / b, b / a == {}"
+    };
+
+    static constexpr auto plan_cmp = cheapest_plan(std::array{
+        has_cmp ? std::size_t{} : kNoPlan,
+        plan_cost({{fused, kFused, 1}}),
+        plan_cost({{has_and, kCost.op_and, 1}, {has_eq, kCost.op_eq, 2}}),
+        plan_cost({{has_or, kCost.op_or, 1}, {has_eq, kCost.op_eq, 2}}),
+        plan_cost({{has_sub && kEmpty, kCost.op_sub, 2}, {has_eq, kCost.op_eq, 2}}),
+    });
 
     static constexpr auto op_and(const _Tp &a, const _Tp &b) -> decltype(auto)
-        requires(has_sub || (has_or && (has_xor || has_not)))
+        requires(plan_and != kNoPlan)
     {
-        if constexpr (has_and) {
+        if constexpr (plan_and == 0)
             return a & b;
-        } else if constexpr (has_sub) {
+        else if constexpr (plan_and == 1)
+            return _S_fused<set_expr_op::op_and>(a, b);
+        else if constexpr (plan_and == 2)
             return a / (a / b);
-        } else if constexpr (has_or && has_xor) {
+        else if constexpr (plan_and == 3)
             return (a | b) ^ (a ^ b);
-        } else if constexpr (has_or && has_not) {
+        else
             return ~((~a) | (~b));
-        } else {
-            static_assert(false);
-        }
     }
 
     static constexpr auto op_or(const _Tp &a, const _Tp &b) -> decltype(auto)
-        requires((has_and || has_sub) && (has_xor || has_not))
+        requires(plan_or != kNoPlan)
     {
-        if constexpr (has_or) {
+        if constexpr (plan_or == 0)
             return a | b;
-        } else if constexpr (has_sub && has_xor) {
+        else if constexpr (plan_or == 1)
+            return _S_fused<set_expr_op::op_or>(a, b);
+        else if constexpr (plan_or == 2)
             return (a / b) ^ b;
-        } else if constexpr (has_and && has_xor) {
+        else if constexpr (plan_or == 3)
             return (a & b) ^ (a ^ b);
-        } else if constexpr (has_sub && has_not) {
+        else if constexpr (plan_or == 4)
             return ~((~a) / b);
-        } else if constexpr (has_and && has_not) {
+        else
             return ~((~a) & (~b));
-        } else {
-            static_assert(false);
-        }
     }
 
     static constexpr auto op_xor(const _Tp &a, const _Tp &b) -> decltype(auto)
-        requires((has_not && (has_sub || has_or || has_and)) || (has_sub && has_or))
+        requires(plan_xor != kNoPlan)
     {
-        if constexpr (has_xor) {
+        if constexpr (plan_xor == 0) {
             return a ^ b;
-        } else if constexpr (has_sub && has_or) {
+        } else if constexpr (plan_xor == 1) {
+            return _S_fused<set_expr_op::op_xor>(a, b);
+        } else if constexpr (plan_xor == 2) {
             return (a / b) | (b / a);
-        } else if constexpr (has_not && has_sub) {
+        } else if constexpr (plan_xor == 3) {
             const auto tmp = ~b;
             return (~(tmp / a)) / (a / tmp);
-        } else if constexpr (has_not && has_or) {
+        } else if constexpr (plan_xor == 4) {
             return (~(a | ~b)) | (~(~a | b));
-        } else if constexpr (has_not && has_and) {
-            return (~(a & b)) & (~((~a) & (~b)));
         } else {
-            static_assert(false);
+            return (~(a & b)) & (~((~a) & (~b)));
         }
     }
 
     static constexpr auto op_sub(const _Tp &a, const _Tp &b) -> decltype(auto)
-        requires((has_and || has_or) && (has_xor || has_not))
+        requires(plan_sub != kNoPlan)
     {
-        if constexpr (has_sub) {
+        if constexpr (plan_sub == 0)
             return a / b;
-        } else if constexpr (has_and && has_xor) {
+        else if constexpr (plan_sub == 1)
+            return _S_fused<set_expr_op::op_sub>(a, b);
+        else if constexpr (plan_sub == 2)
             return (a & b) ^ a;
-        } else if constexpr (has_or && has_xor) {
+        else if constexpr (plan_sub == 3)
             return (a | b) ^ b;
-        } else if constexpr (has_and && has_not) {
+        else if constexpr (plan_sub == 4)
             return a & (~b);
-        } else if constexpr (has_or && has_not) {
+        else
             return ~(~a | b);
-        } else {
-            static_assert(false);
-        }
     }
 
     static constexpr auto op_cmp(const _Tp &a, const _Tp &b) -> std::partial_ordering
-        requires(
-            has_eq && (has_and || has_or || (has_sub && std::constructible_from<_Tp>))
-        )
+        requires(plan_cmp != kNoPlan)
     {
-        if constexpr (has_cmp) {
+        if constexpr (plan_cmp == 0) {
             return a <=> b;
         } else {
             const auto [pred_le, pred_ge] = [&a, &b] {
                 struct Pred {
                     bool le, ge;
                 };
-                if constexpr (has_and) {
+                if constexpr (plan_cmp == 1) {
+                    const auto [le, ge] = fused_subsets(a, b);
+                    return Pred{le, ge};
+                } else if constexpr (plan_cmp == 2) {
                     const auto set_intersect = a & b;
                     return Pred{a == set_intersect, b == set_intersect};
-                } else if constexpr (has_or) {
+                } else if constexpr (plan_cmp == 3) {
                     const auto set_union = a | b;
                     return Pred{b == set_union, a == set_union};
                 } else {
@@ -251,6 +798,115 @@ inline constexpr auto operator<=>(_Tp &&a, _Up &&b) -> std::partial_ordering {
     return __detail::set_op_impl<std::remove_cvref_t<_Tp>>::op_cmp(a, b);
 }
 
+namespace __detail {
+
+template <set_expr_op _Op>
+inline constexpr auto has_in_place(const set_in_place &in_place) -> bool {
+    if constexpr (_Op == set_expr_op::op_and)
+        return in_place.op_and;
+    else if constexpr (_Op == set_expr_op::op_or)
+        return in_place.op_or;
+    else if constexpr (_Op == set_expr_op::op_xor)
+        return in_place.op_xor;
+    else
+        return in_place.op_sub;
+}
+
+template <set_expr_op _Op, typename _Tp>
+inline constexpr auto apply_set_op(_Tp &&a, const std::remove_cvref_t<_Tp> &b)
+    -> decltype(auto) {
+    if constexpr (_Op == set_expr_op::op_and)
+        return std::forward<_Tp>(a) & b;
+    else if constexpr (_Op == set_expr_op::op_or)
+        return std::forward<_Tp>(a) | b;
+    else if constexpr (_Op == set_expr_op::op_xor)
+        return std::forward<_Tp>(a) ^ b;
+    else
+        return std::forward<_Tp>(a) / b;
+}
+
+// sorted sets such as std::set, whose erase and insert leave the other elements in place
+template <typename _Tp>
+concept node_set_like = sorted_set_like<_Tp> && requires(_Tp &a, const _Tp &b) {
+    { a.erase(a.begin()) } -> std::same_as<std::ranges::iterator_t<_Tp>>;
+    a.emplace_hint(a.begin(), *std::ranges::begin(b));
+};
+
+/* a op= b in one merge over both, erasing from and inserting into a. */
+template <set_expr_op _Op, node_set_like _Tp>
+inline auto node_assign(_Tp &a, const _Tp &b) -> void {
+    constexpr auto keep_both = _Op == set_expr_op::op_and || _Op == set_expr_op::op_or;
+    constexpr auto insert    = _Op == set_expr_op::op_or || _Op == set_expr_op::op_xor;
+    if (&a == &b) {
+        if constexpr (!keep_both)
+            a.clear();
+        return;
+    }
+    auto x          = a.begin();
+    auto y          = std::ranges::begin(b);
+    const auto last = std::ranges::end(b);
+    while (x != a.end() && y != last) {
+        if (*x < *y) {
+            x = _Op == set_expr_op::op_and ? a.erase(x) : std::next(x);
+        } else if (*y < *x) {
+            if constexpr (insert)
+                a.emplace_hint(x, *y);
+            ++y;
+        } else {
+            x = keep_both ? std::next(x) : a.erase(x);
+            ++y;
+        }
+    }
+    if constexpr (_Op == set_expr_op::op_and)
+        a.erase(x, a.end());
+    if constexpr (insert)
+        for (; y != last; ++y)
+            a.emplace_hint(a.end(), *y);
+}
+
+// _Tp comes from the left operand, so a const one is not set_like
+template <typename _Tp, set_expr_op _Op>
+concept set_generate_assign =
+    set_like<_Tp> && !has_in_place<_Op>(set_in_place_of<_Tp>()) &&
+    std::movable<_Tp> && requires(_Tp &a, const _Tp &b) {
+        { apply_set_op<_Op>(std::move(a), b) } -> std::convertible_to<_Tp>;
+    };
+
+template <set_expr_op _Op, typename _Tp>
+inline constexpr auto set_assign(_Tp &a, const _Tp &b) -> _Tp & {
+    if constexpr (node_set_like<_Tp>)
+        node_assign<_Op>(a, b);
+    else
+        a = apply_set_op<_Op>(std::move(a), b);
+    return a;
+}
+
+} // namespace __detail
+
+template <typename _Tp>
+    requires(__detail::set_generate_assign<_Tp, __detail::set_expr_op::op_and>)
+inline constexpr auto operator&=(_Tp &a, const _Tp &b) -> _Tp & {
+    return __detail::set_assign<__detail::set_expr_op::op_and>(a, b);
+}
+
+template <typename _Tp>
+    requires(__detail::set_generate_assign<_Tp, __detail::set_expr_op::op_or>)
+inline constexpr auto operator|=(_Tp &a, const _Tp &b) -> _Tp & {
+    return __detail::set_assign<__detail::set_expr_op::op_or>(a, b);
+}
+
+template <typename _Tp>
+    requires(__detail::set_generate_assign<_Tp, __detail::set_expr_op::op_xor>)
+inline constexpr auto operator^=(_Tp &a, const _Tp &b) -> _Tp & {
+    return __detail::set_assign<__detail::set_expr_op::op_xor>(a, b);
+}
+
+template <typename _Tp>
+    requires(__detail::set_generate_assign<_Tp, __detail::set_expr_op::op_sub>)
+inline constexpr auto operator/=(_Tp &a, const _Tp &b) -> _Tp & {
+    return __detail::set_assign<__detail::set_expr_op::op_sub>(a, b);
+}
+
 template <std::constructible_from<> _Tp>
 inline constexpr auto empty_set() -> _Tp {
     return _Tp{};
@@ -0,0 +1,127 @@
+#include "../bench/timing.h"
+#include "sop.h"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <random>
+#include <ratio>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <std::size_t _Inputs>
+auto show(const boolean::sum_of_products<_Inputs> &sop) -> std::string {
+    auto text = std::string{};
+    for (const auto &product : sop.cubes) {
+        text += text.empty() ? "" : " | ";
+        for (std::size_t i = 0; i < _Inputs; ++i)
+            if ((product.mask >> i) & 1)
+                text += std::format("{}x{}", (product.value >> i) & 1 ? "" : "~", i);
+    }
+    return text.empty() ? "0" : text;
+}
+
+// at least 3 of 5, fixed at compile time
+constexpr auto majority = boolean::compile_sop<[] {
+    return boolean::make_sliced<5>([](const auto &x) {
+        auto result = ~boolean::sliced_table<5>::constant(true);
+        for (std::size_t i = 0; i < 5; ++i)
+            for (std::size_t j = i + 1; j < 5; ++j)
+                for (std::size_t k = j + 1; k < 5; ++k)
+                    result = result | (x[i] & x[j] & x[k]);
+        return result;
+    });
+}>;
+
+static_assert(majority(0b10101) && majority(0b01110) && !majority(0b10001));
+
+/* A 16-input rule: a few products of 3 to 6 literals, spelled out row by row. */
+auto make_rule(std::mt19937_64 &gen) -> boolean::bool_table<16> {
+    auto products = std::vector<boolean::cube>{};
+    for (std::size_t k = 0; k < 8; ++k) {
+        auto product = boolean::cube{};
+        while (product.literals() < 3 + k % 4)
+            product.mask |= std::uint64_t{1} << (gen() % 16);
+        product.value = gen() & product.mask;
+        products.push_back(product);
+    }
+    auto rule = boolean::bool_table<16>{};
+    for (std::size_t r = 0; r < rule.size(); ++r)
+        for (const auto &product : products)
+            rule[r] = rule[r] || product.contains(r);
+    return rule;
+}
+
+} // namespace
+
+auto main() -> int {
+    // the primes among 0 to 9, as 4 bits, not caring about 10 to 15
+    auto prime = boolean::bool_table<4>{};
+    auto bcd   = boolean::bool_table<4>{};
+    for (const auto digit : {2, 3, 5, 7})
+        prime.set(digit);
+    for (std::size_t invalid = 10; invalid < 16; ++invalid)
+        bcd.set(invalid);
+    std::cout << std::format("primes in bcd: {}\n", show(boolean::minimize(prime, bcd)));
+
+    // all 32 rows of the compiled majority at once, twice over
+    auto every = std::array<std::uint64_t, 64>{};
+    for (std::size_t j = 0; j < every.size(); ++j)
+        every[j] = j % 32;
+    const auto outputs = majority(boolean::slice_rows<5>(every));
+    std::cout << std::format("majority of 5: {:064b}\n", outputs);
+
+    auto gen        = std::mt19937_64{42};
+    const auto rule = make_rule(gen);
+    const auto sop  = measure_once<std::milli>("16 inputs, minimize", [&] {
+        return boolean::minimize(rule);
+    });
+    std::cout << std::format(
+        ", {} cubes of {} literals: {}\n", sop.cubes.size(), sop.literals(), show(sop)
+    );
+
+    // classify records stored both ways: a row each, or 64 to a block of input columns
+    constexpr auto kRows = std::size_t{1} << 22;
+    auto rows            = std::vector<std::uint64_t>(kRows);
+    for (auto &row : rows)
+        row = gen() & 0xFFFF;
+    const auto block_at = [&rows](std::size_t j) {
+        return boolean::slice_rows<16>(std::span{rows}.subspan(j).first<64>());
+    };
+    auto columns = std::vector<std::array<std::uint64_t, 16>>{};
+    for (std::size_t j = 0; j < kRows; j += 64)
+        columns.push_back(block_at(j));
+
+    const auto report = [](std::size_t total) {
+        std::cout << std::format(" ({})\n", total);
+    };
+    report(measure_once<std::milli>("  rows, by lookup   ", [&] {
+        auto total = std::size_t{};
+        for (const auto row : rows)
+            total += rule[row];
+        return total;
+    }));
+    report(measure_once<std::milli>("  rows, sop         ", [&] {
+        auto total = std::size_t{};
+        for (const auto row : rows)
+            total += sop(row);
+        return total;
+    }));
+    report(measure_once<std::milli>("  rows, sliced, sop ", [&] {
+        auto total = std::size_t{};
+        for (std::size_t j = 0; j < kRows; j += 64)
+            total += static_cast<std::size_t>(std::popcount(sop(block_at(j))));
+        return total;
+    }));
+    report(measure_once<std::milli>("  columns, sop      ", [&] {
+        auto total = std::size_t{};
+        for (const auto &block : columns)
+            total += static_cast<std::size_t>(std::popcount(sop(block)));
+        return total;
+    }));
+}
@@ -0,0 +1,402 @@
+#pragma once
+#include "bools.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace boolean {
+
+/* A product of literals: input i is in it when bit i of mask is, as bit i of value. */
+struct cube {
+    std::uint64_t mask  = 0;
+    std::uint64_t value = 0; // within mask
+
+    constexpr auto contains(std::uint64_t row) const -> bool {
+        return (row & mask) == value;
+    }
+
+    constexpr auto literals() const -> std::size_t {
+        return static_cast<std::size_t>(std::popcount(mask));
+    }
+
+    friend constexpr auto operator==(const cube &, const cube &) -> bool = default;
+};
+
+namespace __detail {
+
+template <std::size_t _Inputs>
+constexpr auto cube_table(const cube &product) -> sliced_table<_Inputs> {
+    auto result = sliced_table<_Inputs>::constant(true);
+    for (auto rest = product.mask; rest != 0; rest &= rest - 1) {
+        const auto i = static_cast<std::size_t>(std::countr_zero(rest));
+        const auto x = sliced_table<_Inputs>::projection(i);
+        result       = result & ((product.value >> i) & 1 ? x : ~x);
+    }
+    return result;
+}
+
+// call fn(row) for each row where the table is 1, in increasing order
+template <std::size_t _Inputs, typename _Fn>
+constexpr auto for_each_row(const sliced_table<_Inputs> &table, _Fn &&fn) -> void {
+    const auto &words = table.words();
+    for (std::size_t w = 0; w < words.size(); ++w)
+        for (auto bits = words[w]; bits != 0; bits &= bits - 1)
+            fn(w * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+}
+
+template <std::size_t _Inputs>
+constexpr auto first_row(const sliced_table<_Inputs> &table) -> std::size_t {
+    const auto &words = table.words();
+    auto w            = std::size_t{};
+    while (words[w] == 0)
+        ++w;
+    return w * 64 + static_cast<std::size_t>(std::countr_zero(words[w]));
+}
+
+// x[i] is input i of the 64 rows, so a literal is x[i] or ~x[i]
+constexpr auto literal_mask(const cube &product, std::size_t i) -> std::uint64_t {
+    return ((product.value >> i) & 1) - 1; // 0 to keep x[i], all ones to negate it
+}
+
+inline constexpr auto kSearchNodes = std::size_t{1} << 14;
+
+/**
+ * Quine-McCluskey, a table at a time. implicants holds the rows whose cube,
+ * with the inputs in free left free, lies in care: freeing input i as well
+ * keeps the rows where both the row and its flip along i do. Rows which no
+ * flip keeps are primes, each repeated over its free inputs.
+ */
+template <std::size_t _Inputs>
+struct prime_search {
+    using _Table = sliced_table<_Inputs>;
+
+    static constexpr auto kAll = (std::uint64_t{1} << _Inputs) - 1;
+
+    const _Table &on;
+    std::vector<cube> primes;
+
+    constexpr auto search(std::uint64_t free, std::size_t from, const _Table &implicants)
+        -> void {
+        auto grown = _Table{};
+        for (std::size_t i = 0; i < _Inputs; ++i) {
+            if ((free >> i) & 1)
+                continue;
+            const auto next = implicants & implicants.flip(i);
+            grown           = grown | next;
+            // each set of free inputs once, grown in increasing order
+            if (i >= from && next != _Table{})
+                this->search(free | std::uint64_t{1} << i, i + 1, next);
+        }
+
+        auto first = implicants & ~grown; // a row per prime: its free inputs 0
+        for (auto rest = free; rest != 0; rest &= rest - 1) {
+            const auto i = static_cast<std::size_t>(std::countr_zero(rest));
+            first        = first & ~_Table::projection(i);
+        }
+        for_each_row(first, [&](std::size_t row) {
+            const auto prime = cube{kAll & ~free, row};
+            // those wholly in the don't-cares are no use
+            if ((cube_table<_Inputs>(prime) & on) != _Table{})
+                primes.push_back(prime);
+        });
+    }
+};
+
+/**
+ * Branch and bound over the primes which cover the lowest row left, from the
+ * greedy cover, for a cover with the fewest cubes and then literals.
+ */
+template <std::size_t _Inputs>
+struct cover_search {
+    using _Table = sliced_table<_Inputs>;
+
+    std::vector<cube> primes;
+    std::vector<_Table> tables;
+    std::vector<std::size_t> chosen = {};
+    std::vector<std::size_t> best   = {};
+    std::size_t nodes               = kSearchNodes;
+
+    constexpr auto literals(const std::vector<std::size_t> &picks) const -> std::size_t {
+        auto total = std::size_t{};
+        for (const auto k : picks)
+            total += primes[k].literals();
+        return total;
+    }
+
+    constexpr auto greedy(_Table left) -> void {
+        while (left != _Table{}) {
+            auto pick = std::size_t{};
+            auto most = std::size_t{};
+            for (std::size_t k = 0; k < primes.size(); ++k) {
+                const auto covered = (tables[k] & left).count();
+                if (covered > most ||
+                    (covered == most && primes[k].literals() < primes[pick].literals())) {
+                    pick = k;
+                    most = covered;
+                }
+            }
+            best.push_back(pick);
+            left = left & ~tables[pick];
+        }
+    }
+
+    // drop each pick whose rows of left the others cover, the last picked first
+    constexpr auto irredundant(const _Table &left) -> void {
+        for (auto k = best.size(); k-- != 0;) {
+            auto rest = _Table{};
+            for (std::size_t j = 0; j < best.size(); ++j)
+                if (j != k)
+                    rest = rest | tables[best[j]];
+            if ((left & ~rest) == _Table{})
+                best.erase(best.begin() + static_cast<std::ptrdiff_t>(k));
+        }
+    }
+
+    constexpr auto search(const _Table &left) -> void {
+        if (left == _Table{}) {
+            if (chosen.size() < best.size() ||
+                (chosen.size() == best.size() && literals(chosen) < literals(best)))
+                best = chosen;
+            return;
+        }
+        // another cube can't beat best
+        const auto more = chosen.size() + 1;
+        if (nodes == 0 || more > best.size() ||
+            (more == best.size() && literals(chosen) >= literals(best)))
+            return;
+        --nodes;
+
+        const auto row = first_row(left);
+        // the primes which cover the row, those covering the most rows left first
+        auto picks = std::vector<std::pair<std::size_t, std::size_t>>{};
+        for (std::size_t k = 0; k < primes.size(); ++k)
+            if (primes[k].contains(row))
+                picks.emplace_back((tables[k] & left).count(), k);
+        std::ranges::sort(picks, std::greater{});
+
+        for (const auto &[covered, k] : picks) {
+            chosen.push_back(k);
+            this->search(left & ~tables[k]);
+            chosen.pop_back();
+        }
+    }
+};
+
+template <std::size_t _Inputs>
+constexpr auto sliced_term(
+    const std::array<std::uint64_t, _Inputs> &x, const cube &product
+) -> std::uint64_t {
+    auto term = ~std::uint64_t{};
+    for (auto rest = product.mask; rest != 0; rest &= rest - 1) {
+        const auto i = static_cast<std::size_t>(std::countr_zero(rest));
+        term &= x[i] ^ literal_mask(product, i);
+    }
+    return term;
+}
+
+} // namespace __detail
+
+/**
+ * A sum of products: 1 on the rows which any cube contains. Evaluation runs the
+ * same instructions whatever the inputs, with no branch to mispredict.
+ */
+template <std::size_t _Inputs>
+struct sum_of_products {
+    static_assert(_Inputs <= 64 && _Inputs > 0, "Too many inputs");
+
+    static constexpr auto kInputs = _Inputs;
+
+    std::vector<cube> cubes;
+
+    /* The output for one row, whose bit i is input i. */
+    constexpr auto operator()(std::uint64_t row) const -> bool {
+        auto result = false;
+        for (const auto &product : cubes)
+            result |= product.contains(row);
+        return result;
+    }
+
+    /* The outputs of 64 rows from slice_rows: bit j of the result is row j's. */
+    constexpr auto operator()(const std::array<std::uint64_t, _Inputs> &x) const
+        -> std::uint64_t {
+        auto result = std::uint64_t{};
+        for (const auto &product : cubes)
+            result |= __detail::sliced_term(x, product);
+        return result;
+    }
+
+    constexpr auto literals() const -> std::size_t {
+        auto total = std::size_t{};
+        for (const auto &product : cubes)
+            total += product.literals();
+        return total;
+    }
+
+    constexpr auto to_sliced() const -> sliced_table<_Inputs> {
+        auto result = sliced_table<_Inputs>{};
+        for (const auto &product : cubes)
+            result = result | __detail::cube_table<_Inputs>(product);
+        return result;
+    }
+};
+
+/**
+ * A sum of products fixed at compile time, unrolled into straight-line &, | and
+ * ~ over the sliced inputs. See compile_sop.
+ */
+template <std::size_t _Inputs, cube... _Cubes>
+struct compiled_sop {
+    static constexpr auto kInputs = _Inputs;
+
+    constexpr auto operator()(std::uint64_t row) const -> bool {
+        return (false | ... | _Cubes.contains(row));
+    }
+
+    constexpr auto operator()(const std::array<std::uint64_t, _Inputs> &x) const
+        -> std::uint64_t {
+        return (std::uint64_t{} | ... | _S_term<_Cubes>(x));
+    }
+
+private:
+    template <cube _Cube>
+    static constexpr auto _S_term(const std::array<std::uint64_t, _Inputs> &x)
+        -> std::uint64_t {
+        return [&x]<std::size_t... _Is>(std::index_sequence<_Is...>) {
+            return (~std::uint64_t{} & ... & _S_literal<_Cube, _Is>(x));
+        }(std::make_index_sequence<_Inputs>{});
+    }
+
+    template <cube _Cube, std::size_t _Is>
+    static constexpr auto _S_literal(const std::array<std::uint64_t, _Inputs> &x)
+        -> std::uint64_t {
+        if constexpr (((_Cube.mask >> _Is) & 1) == 0)
+            return ~std::uint64_t{};
+        else
+            return x[_Is] ^ __detail::literal_mask(_Cube, _Is);
+    }
+};
+
+/**
+ * A cover of on by primes of on | dont_care, with the fewest cubes and then
+ * literals. The primes come from all cubes of the table at once, up to 4^N / 64
+ * word operations; the cover, from a search of kSearchNodes nodes at most, is
+ * the best found if that runs out, and no cube of it is covered by the rest.
+ */
+template <std::size_t _Inputs>
+constexpr auto minimize(
+    const sliced_table<_Inputs> &on, const sliced_table<_Inputs> &dont_care = {}
+) -> sum_of_products<_Inputs> {
+    static_assert(_Inputs <= 16, "Too many inputs to minimize");
+    using _Table = sliced_table<_Inputs>;
+
+    auto primes = __detail::prime_search<_Inputs>{on, {}};
+    if (on != _Table{})
+        primes.search(0, 0, on | dont_care);
+
+    auto tables = std::vector<_Table>{};
+    tables.reserve(primes.primes.size());
+    auto once  = _Table{};
+    auto twice = _Table{};
+    for (const auto &prime : primes.primes) {
+        tables.push_back(__detail::cube_table<_Inputs>(prime) & on);
+        twice = twice | (once & tables.back());
+        once  = once | tables.back();
+    }
+    once = once & ~twice;
+
+    // the primes alone on some row are in every cover
+    auto result = sum_of_products<_Inputs>{};
+    auto cover  = __detail::cover_search<_Inputs>{};
+    auto left   = on;
+    for (std::size_t k = 0; k < tables.size(); ++k) {
+        if ((tables[k] & once) != _Table{}) {
+            result.cubes.push_back(primes.primes[k]);
+            left = left & ~tables[k];
+        }
+    }
+    for (std::size_t k = 0; k < tables.size(); ++k) {
+        if ((tables[k] & once) == _Table{} && (tables[k] & left) != _Table{}) {
+            cover.primes.push_back(primes.primes[k]);
+            cover.tables.push_back(tables[k]);
+        }
+    }
+
+    // a search cut short leaves a cover which may hold a cube too many
+    cover.greedy(left);
+    cover.irredundant(left);
+    cover.search(left);
+    cover.irredundant(left);
+    for (const auto k : cover.best)
+        result.cubes.push_back(cover.primes[k]);
+    return result;
+}
+
+template <std::size_t _Inputs>
+constexpr auto minimize(
+    const bool_table<_Inputs> &on, const bool_table<_Inputs> &dont_care = {}
+) -> sum_of_products<_Inputs> {
+    return minimize(sliced_table<_Inputs>{on}, sliced_table<_Inputs>{dont_care});
+}
+
+/**
+ * 64 rows in bit-sliced form, the inputs of the evaluators above: bit j of word
+ * i is input i of rows[j], by a 64 x 64 bit transpose.
+ */
+template <std::size_t _Inputs>
+    requires(_Inputs <= 64)
+constexpr auto slice_rows(std::span<const std::uint64_t, 64> rows)
+    -> std::array<std::uint64_t, _Inputs> {
+    auto words = std::array<std::uint64_t, 64>{};
+    std::ranges::copy(rows, words.begin());
+    __detail::transpose(words);
+
+    auto result = std::array<std::uint64_t, _Inputs>{};
+    std::copy_n(words.begin(), _Inputs, result.begin());
+    return result;
+}
+
+namespace __detail {
+
+template <auto _Make>
+struct compile_sop {
+    static constexpr auto kTable  = _Make();
+    static constexpr auto kInputs = decltype(minimize(kTable))::kInputs;
+
+    using _Cover = std::pair<std::array<cube, std::size_t{1} << kInputs>, std::size_t>;
+
+    // a vector can't outlive constant evaluation, so copy it out, a cube per row at most
+    static constexpr auto kCover = [] {
+        const auto sop = minimize(kTable);
+        auto cover     = _Cover{};
+        std::ranges::copy(sop.cubes, cover.first.begin());
+        cover.second = sop.cubes.size();
+        return cover;
+    }();
+
+    static constexpr auto kCount = kCover.second;
+    static constexpr auto kCubes = kCover.first;
+
+    template <std::size_t... _Is>
+    static auto _S_unroll(std::index_sequence<_Is...>)
+        -> compiled_sop<kInputs, kCubes[_Is]...>;
+
+    using type = decltype(_S_unroll(std::make_index_sequence<kCount>{}));
+};
+
+} // namespace __detail
+
+/**
+ * The table from _Make(), minimized and unrolled at compile time, e.g.
+ * compile_sop<[] { return make_sliced<3>(...); }>. It takes a small table, as
+ * the minimizer runs in constant evaluation.
+ */
+template <auto _Make>
+inline constexpr auto compile_sop = typename __detail::compile_sop<_Make>::type{};
+
+} // namespace boolean